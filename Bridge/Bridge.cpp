@@ -1,14 +1,220 @@
 #include <memory>
 #include <array>
 #include <iostream>
+#include <span>
+#include <typeinfo>
 
 using Vec = std::array<double, 3>;
 
+// ---- Trace.h ----
+// Diagnostics for the hot paths. The level is fixed at compile time with BRIDGE_TRACE_LEVEL
+// (0 = off, 1 = counters, 2 = counters and events), everything above it compiles to nothing.
+// Every thread writes into its own buffers without locks, trace::Dump prints them on demand.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+#ifndef BRIDGE_TRACE_LEVEL
+#define BRIDGE_TRACE_LEVEL 0
+#endif
+
+namespace trace {
+
+enum class Level { off = 0, counters = 1, events = 2 };
+
+template <Level L>
+constexpr bool enabled = L != Level::off && static_cast<int>(L) <= BRIDGE_TRACE_LEVEL;
+
+inline std::uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Written by its owning thread only. Keys are string literals and compared by address,
+// a reader sees a slot once its key has been published.
+class ThreadBuffer {
+public:
+    static constexpr std::size_t max_counters{64};
+    static constexpr std::size_t max_events{4096};
+
+    void Count(const char* key, std::uint64_t n, std::uint64_t ns) {
+        for (auto& c : counters_) {
+            const char* k = c.key.load(std::memory_order_relaxed);
+            if (k == nullptr) {
+                c.key.store(key, std::memory_order_release);
+                k = key;
+            }
+            if (k == key) {
+                c.count.fetch_add(n, std::memory_order_relaxed);
+                c.ns.fetch_add(ns, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    // Ring buffer slot with a sequence number, so a concurrent Dump can skip half written events.
+    void Record(const char* what, std::uint64_t value) {
+        const std::uint64_t h = head_.load(std::memory_order_relaxed);
+        Event& e = events_[h % max_events];
+        e.seq.store(2 * h + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        e.time.store(Now(), std::memory_order_relaxed);
+        e.what.store(what, std::memory_order_relaxed);
+        e.value.store(value, std::memory_order_relaxed);
+        e.seq.store(2 * h + 2, std::memory_order_release);
+        head_.store(h + 1, std::memory_order_release);
+    }
+
+    void Dump(std::ostream& os) const {
+        for (const auto& c : counters_) {
+            const char* key = c.key.load(std::memory_order_acquire);
+            if (key == nullptr)
+                break;
+            const auto count = c.count.load(std::memory_order_relaxed);
+            const auto ns = c.ns.load(std::memory_order_relaxed);
+            os << "  " << key << ": " << count;
+            if (ns > 0)
+                os << " in " << ns * 1e-6 << " ms";
+            os << '\n';
+        }
+        const std::uint64_t head = head_.load(std::memory_order_acquire);
+        for (std::uint64_t h = head > max_events ? head - max_events : 0; h < head; ++h) {
+            const Event& e = events_[h % max_events];
+            const auto seq = e.seq.load(std::memory_order_acquire);
+            const auto time = e.time.load(std::memory_order_relaxed);
+            const char* what = e.what.load(std::memory_order_relaxed);
+            const auto value = e.value.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq != 2 * h + 2 || e.seq.load(std::memory_order_relaxed) != seq)
+                continue;
+            os << "  [" << time << "] " << what << ' ' << value << '\n';
+        }
+    }
+
+private:
+    struct Counter {
+        std::atomic<const char*> key{nullptr};
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> ns{0};
+    };
+    struct Event {
+        std::atomic<std::uint64_t> seq{0};
+        std::atomic<std::uint64_t> time{0};
+        std::atomic<const char*> what{nullptr};
+        std::atomic<std::uint64_t> value{0};
+    };
+
+    std::array<Counter, max_counters> counters_;
+    std::array<Event, max_events> events_;
+    std::atomic<std::uint64_t> head_{0};
+};
+
+// Buffers live until the end of the program, so they can be dumped after their thread has exited.
+class Registry {
+public:
+    static Registry& Instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    ThreadBuffer& Local() {
+        thread_local ThreadBuffer* buffer = [this] {
+            std::lock_guard lock{mutex_};
+            return buffers_.emplace_back(std::make_unique<ThreadBuffer>()).get();
+        }();
+        return *buffer;
+    }
+
+    void Dump(std::ostream& os) {
+        std::lock_guard lock{mutex_};
+        for (std::size_t t = 0; t < buffers_.size(); ++t) {
+            os << "trace buffer " << t << ":\n";
+            buffers_[t]->Dump(os);
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+// Keys can also be given as callables returning the key (e.g. a virtual Mover::Name() call),
+// they are only invoked when the level is enabled.
+template <typename K>
+inline const char* Key(K&& key) {
+    if constexpr (std::is_invocable_v<K>)
+        return key();
+    else
+        return key;
+}
+
+template <Level L, typename K>
+inline void Count(K&& key, std::uint64_t n = 1) {
+    if constexpr (enabled<L>)
+        Registry::Instance().Local().Count(Key(key), n, 0);
+}
+
+template <Level L, typename K>
+inline void Event(K&& what, std::uint64_t value = 0) {
+    if constexpr (enabled<L>)
+        Registry::Instance().Local().Record(Key(what), value);
+}
+
+// counts `n` under `key` and adds the time until the end of the scope
+template <Level L>
+class ScopedTimer {
+public:
+    template <typename K>
+    ScopedTimer(K&& key, std::uint64_t n) {
+        if constexpr (enabled<L>) {
+            key_ = Key(key);
+            n_ = n;
+            start_ = Now();
+        }
+    }
+    ~ScopedTimer() {
+        if constexpr (enabled<L>)
+            Registry::Instance().Local().Count(key_, n_, Now() - start_);
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const char* key_{nullptr};
+    std::uint64_t n_{0};
+    std::uint64_t start_{0};
+};
+
+inline void Dump(std::ostream& os) {
+    if constexpr (BRIDGE_TRACE_LEVEL > 0)
+        Registry::Instance().Dump(os);
+    else
+        os << "tracing is compiled out (BRIDGE_TRACE_LEVEL=0)\n";
+}
+}  // namespace trace
+
 class Mover{
 public:
     virtual ~Mover() = default;
-    virtual Vec GetNewCoords(Vec old) = 0;
+    virtual Vec GetNewCoords(const Vec& old) = 0;
     virtual void WhoAmI() = 0;
+
+    // key for the trace counters, has to be a string with static storage duration
+    virtual const char* Name() const { return typeid(*this).name(); }
+
+    // false for movers whose objects interact, their UpdateCoords has to see the whole population
+    virtual bool IsSeparable() const { return true; }
+
+    // Batch entry point, advances all coordinates with a single virtual call.
+    // Implementations should override it with a loop over their own GetNewCoords.
+    virtual void UpdateCoords(std::span<Vec> coords) {
+        for (auto& c : coords)
+            c = GetNewCoords(c);
+    }
 };
 
 class Object {
@@ -18,7 +224,7 @@ protected:
 public:
     virtual ~Object() = default;
     virtual void move() = 0;
-    virtual void WhereAmI() = 0;
+    virtual void WhereAmI() const = 0;
 
 protected:
     Mover* getMover() { return move_pimpl.get(); }
@@ -28,39 +234,846 @@ private:
     std::unique_ptr<Mover> move_pimpl;
 };
 
-class SimpleMover : public Mover {
+class SimpleMover final : public Mover {
 public:
-    Vec GetNewCoords(Vec old) override {
-        old[0] += 1.;
-        return old;
+    Vec GetNewCoords(const Vec& old) override {
+        Vec coords{old};
+        coords[0] += 1.;
+        return coords;
     }
     void WhoAmI() override {
         std::cout << "I am a simple mover\n";
     }
+    const char* Name() const override { return "SimpleMover"; }
+    void UpdateCoords(std::span<Vec> coords) override {
+        for (auto& c : coords)
+            c[0] += 1.;
+    }
+};
+
+// ---- MovingObject.h ----
+// The mover is a policy: any type with Vec GetNewCoords(const Vec&), e.g. a final Mover like
+// SimpleMover. It is stored inline and its calls are resolved at compile time.
+// MovingObject<DynamicMover> is the classic runtime bridge, an Object with a heap allocated Mover
+// that can be chosen at runtime. Both offer the same move()/WhereAmI() interface.
+#include <concepts>
+#include <utility>
+
+template <typename P>
+concept MoverPolicy = requires(P p, const Vec& v) {
+    { p.GetNewCoords(v) } -> std::same_as<Vec>;
+};
+
+// selects the type-erased path through Object and Mover
+struct DynamicMover {};
+
+template <typename P>
+const char* MoverName(const P& mover) {
+    if constexpr (requires { { mover.Name() } -> std::convertible_to<const char*>; })
+        return mover.Name();
+    else
+        return typeid(P).name();
+}
+
+template <typename Policy = DynamicMover>
+class MovingObject {
+public:
+    // constructs the mover; never taken for a MovingObject argument, which the copy and move
+    // constructors handle
+    template <typename... Args>
+        requires std::constructible_from<Policy, Args...> &&
+                 (!std::same_as<std::remove_cvref_t<Args>, MovingObject> && ...)
+    explicit MovingObject(Args&&... args)
+        : mover(std::forward<Args>(args)...) {}
+
+    void move() {
+        trace::Count<trace::Level::counters>([this] { return MoverName(mover); });
+        trace::Event<trace::Level::events>([this] { return MoverName(mover); });
+        coords = mover.GetNewCoords(coords);
+    }
+
+    void WhereAmI() const {
+        std::cout << "I am here: " << coords[0] << " " << coords[1] << " " << coords[2] << '\n';
+    }
+
+private:
+    static_assert(MoverPolicy<Policy>, "a mover policy needs Vec GetNewCoords(const Vec&)");
+    Policy mover;
+    Vec coords{0., 0., 0.};
 };
 
-class MovingObject : public Object {
+template <>
+class MovingObject<DynamicMover> : public Object {
 public:
-    MovingObject()
-        : Object{std::make_unique<SimpleMover>()}{
+    explicit MovingObject(std::unique_ptr<Mover> mover = std::make_unique<SimpleMover>())
+        : Object{std::move(mover)}{
         coords[0] = coords[1] = coords[2] = 0.;
     }
     void move() override {
-        getMover()->WhoAmI();
+        trace::Count<trace::Level::counters>([this] { return getMover()->Name(); });
+        trace::Event<trace::Level::events>([this] { return getMover()->Name(); });
         coords = getMover()->GetNewCoords(coords);
     }
 
-    void WhereAmI() override {
-        std::cout << "I am here: " << coords[0] << " " << coords[1] << " " << coords[2] << std::endl;
+    void WhereAmI() const override {
+        std::cout << "I am here: " << coords[0] << " " << coords[1] << " " << coords[2] << '\n';
     }
 
 private:
     Vec coords;
 };
 
-int main() {
+// ---- MovingObjects.h ----
+// Many moving objects, grouped by the implementation of their mover. All coordinates of a group
+// are stored contiguously and advanced by a single call to Mover::UpdateCoords. Each group holds
+// one mover instance for all of its objects, which is also where interacting movers keep the
+// state of their population.
+#include <map>
+#include <stdexcept>
+#include <typeindex>
+#include <vector>
+class MovingObjects {
+public:
+    // `args` construct the group's mover, e.g. BarnesHutMover::Parameters, and can therefore only
+    // come with the first object of a group
+    template <std::derived_from<Mover> TMover, typename... Args>
+    void add(const Vec& coords = Vec{}, Args&&... args) {
+        auto [it, inserted] = groups_.try_emplace(std::type_index{typeid(TMover)});
+        if (inserted)
+            it->second.mover = std::make_unique<TMover>(std::forward<Args>(args)...);
+        else if constexpr (sizeof...(Args) > 0)
+            throw std::logic_error("MovingObjects::add: the group already has its mover");
+        it->second.coords.push_back(coords);
+    }
+
+    void move() {
+        for (auto& [type, group] : groups_) {
+            trace::ScopedTimer<trace::Level::counters> timer{[&] { return group.mover->Name(); }, group.coords.size()};
+            trace::Event<trace::Level::events>("batch", group.coords.size());
+            group.mover->UpdateCoords(group.coords);
+        }
+    }
+
+    void WhereAmI() const {
+        for (const auto& [type, group] : groups_) {
+            group.mover->WhoAmI();
+            for (const auto& c : group.coords)
+                std::cout << "  I am here: " << c[0] << " " << c[1] << " " << c[2] << '\n';
+        }
+    }
+
+    // f(Mover&, std::span<Vec>) for every group
+    template <typename F>
+    void for_each_group(F&& f) {
+        for (auto& [type, group] : groups_)
+            f(*group.mover, std::span<Vec>{group.coords});
+    }
+
+    std::size_t size() const {
+        std::size_t n{0};
+        for (const auto& [type, group] : groups_)
+            n += group.coords.size();
+        return n;
+    }
+
+private:
+    struct Group {
+        std::unique_ptr<Mover> mover;
+        std::vector<Vec> coords;
+    };
+    std::map<std::type_index, Group> groups_;
+};
+
+// ---- OrbitMover.h ----
+// Rotates around the z axis, integrated in many small steps. Much more expensive than
+// SimpleMover, which makes populations with both of them unevenly loaded.
+#include <cmath>
+class OrbitMover final : public Mover {
+public:
+    Vec GetNewCoords(const Vec& old) override {
+        Vec coords{old};
+        for (int i = 0; i < substeps; ++i) {
+            const double x = coords[0];
+            coords[0] = std::cos(dphi) * x - std::sin(dphi) * coords[1];
+            coords[1] = std::sin(dphi) * x + std::cos(dphi) * coords[1];
+        }
+        return coords;
+    }
+    void WhoAmI() override {
+        std::cout << "I am an orbit mover\n";
+    }
+    const char* Name() const override { return "OrbitMover"; }
+    void UpdateCoords(std::span<Vec> coords) override {
+        for (auto& c : coords)
+            c = GetNewCoords(c);
+    }
+
+private:
+    static constexpr int substeps{64};
+    static constexpr double dphi{0.01 / substeps};
+};
+
+// ---- WorkStealingPool.h ----
+// Fixed set of workers, each with its own task deque. A worker takes tasks from the back of its
+// own deque and, once that is empty, steals from the front of the others. Cheap and expensive
+// tasks thereby balance themselves without any cost model. The calling thread acts as worker 0.
+// Idle workers sleep rather than spin, so pools nested inside a task, like a BarnesHutMover's
+// under a ParallelStepper, do not compete with it for the cores.
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+class WorkStealingPool {
+public:
+    using Task = std::function<void(std::size_t task, std::size_t worker)>;
+
+    struct WorkerStats {
+        std::size_t tasks{0};
+        std::size_t steals{0};
+    };
+
+    explicit WorkStealingPool(std::size_t threads = std::thread::hardware_concurrency())
+        : workers_(std::max<std::size_t>(threads, 1)) {
+        for (std::size_t w = 1; w < workers_.size(); ++w)
+            threads_.emplace_back([this, w] { WorkerLoop(w); });
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard lock{mutex_};
+            stop_ = true;
+        }
+        wakeup_.notify_all();
+        for (auto& t : threads_)
+            t.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    std::size_t size() const { return workers_.size(); }
+
+    // calls task(i, worker) for every i in [0, count) and returns once all of them are done
+    void run(std::size_t count, Task task) {
+        if (count == 0)
+            return;
+        task_ = std::move(task);
+        remaining_.store(count, std::memory_order_relaxed);
+        // contiguous blocks per worker, so neighbouring tasks start out on the same thread
+        const std::size_t n = workers_.size();
+        for (std::size_t w = 0; w < n; ++w) {
+            std::lock_guard lock{workers_[w].mutex};
+            for (std::size_t i = w * count / n; i < (w + 1) * count / n; ++i)
+                workers_[w].tasks.push_back(i);
+        }
+        {
+            std::lock_guard lock{mutex_};
+            ++generation_;
+        }
+        wakeup_.notify_all();
+        Work(0);
+    }
+
+    const WorkerStats& stats(std::size_t worker) const { return workers_[worker].stats; }
+
+    void reset_stats() {
+        for (auto& w : workers_)
+            w.stats = WorkerStats{};
+    }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::size_t> tasks;
+        WorkerStats stats;
+    };
+
+    bool Pop(std::size_t self, std::size_t& task) {
+        std::lock_guard lock{workers_[self].mutex};
+        if (workers_[self].tasks.empty())
+            return false;
+        task = workers_[self].tasks.back();
+        workers_[self].tasks.pop_back();
+        return true;
+    }
+
+    bool Steal(std::size_t self, std::size_t& task) {
+        for (std::size_t k = 1; k < workers_.size(); ++k) {
+            auto& victim = workers_[(self + k) % workers_.size()];
+            std::lock_guard lock{victim.mutex};
+            if (!victim.tasks.empty()) {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Tasks are only handed out by run(), so once there is nothing left to pop or steal, a worker
+    // goes back to sleep in WorkerLoop. The caller, worker 0, sleeps until the last running task
+    // is done instead.
+    void Work(std::size_t self) {
+        std::size_t task{};
+        while (true) {
+            const bool own = Pop(self, task);
+            if (!own && !Steal(self, task))
+                break;
+            task_(task, self);
+            ++workers_[self].stats.tasks;
+            if (!own)
+                ++workers_[self].stats.steals;
+            if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                remaining_.notify_all();
+        }
+        if (self != 0)
+            return;
+        for (auto left = remaining_.load(std::memory_order_acquire); left > 0; left = remaining_.load(std::memory_order_acquire))
+            remaining_.wait(left, std::memory_order_acquire);
+    }
+
+    void WorkerLoop(std::size_t self) {
+        std::size_t seen{0};
+        while (true) {
+            {
+                std::unique_lock lock{mutex_};
+                wakeup_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                if (stop_)
+                    return;
+                seen = generation_;
+            }
+            Work(self);
+        }
+    }
+
+    std::vector<Worker> workers_;
+    std::vector<std::thread> threads_;
+    Task task_;
+    std::atomic<std::size_t> remaining_{0};
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::size_t generation_{0};
+    bool stop_{false};
+};
+
+// ---- ParallelStepper.h ----
+// Moves whole populations on a WorkStealingPool. Every mover group is cut into chunks of `grain`
+// objects, each chunk is one task, so a group of slow movers spreads over all threads.
+// Movers are called concurrently on disjoint chunks and must therefore be thread-safe.
+// A group whose mover is not separable is a single task, the mover parallelises it itself.
+class ParallelStepper {
+public:
+    explicit ParallelStepper(std::size_t threads = std::thread::hardware_concurrency(), std::size_t grain = 1024)
+        : pool_{threads}, grain_{std::max<std::size_t>(grain, 1)}, moved_(pool_.size()) {}
+
+    void step(MovingObjects& objects) {
+        chunks_.clear();
+        objects.for_each_group([&](Mover& mover, std::span<Vec> coords) {
+            if (!mover.IsSeparable()) {
+                chunks_.push_back({&mover, coords});
+                return;
+            }
+            for (std::size_t i = 0; i < coords.size(); i += grain_)
+                chunks_.push_back({&mover, coords.subspan(i, std::min(grain_, coords.size() - i))});
+        });
+        pool_.run(chunks_.size(), [this](std::size_t task, std::size_t worker) {
+            const Chunk& chunk = chunks_[task];
+            trace::ScopedTimer<trace::Level::counters> timer{[&] { return chunk.mover->Name(); }, chunk.coords.size()};
+            chunk.mover->UpdateCoords(chunk.coords);
+            moved_[worker] += chunk.coords.size();
+        });
+    }
+
+    void step(std::span<const std::unique_ptr<Object>> objects) {
+        const std::size_t count = (objects.size() + grain_ - 1) / grain_;
+        pool_.run(count, [&](std::size_t task, std::size_t worker) {
+            const auto chunk = objects.subspan(task * grain_, std::min(grain_, objects.size() - task * grain_));
+            for (const auto& object : chunk)
+                object->move();
+            moved_[worker] += chunk.size();
+        });
+    }
+
+    std::size_t threads() const { return pool_.size(); }
+
+    void report(std::ostream& os) const {
+        for (std::size_t w = 0; w < pool_.size(); ++w)
+            os << "  thread " << w << ": " << moved_[w] << " moves, " << pool_.stats(w).tasks << " chunks, "
+               << pool_.stats(w).steals << " stolen\n";
+    }
+
+    void reset_report() {
+        std::fill(moved_.begin(), moved_.end(), 0);
+        pool_.reset_stats();
+    }
+
+private:
+    struct Chunk {
+        Mover* mover;
+        std::span<Vec> coords;
+    };
+
+    WorkStealingPool pool_;
+    std::size_t grain_;
+    std::vector<Chunk> chunks_;
+    std::vector<std::size_t> moved_;
+};
+
+// ---- BarnesHutMover.h ----
+// Gravitating particles of equal mass, advanced with a symplectic Euler step. The accelerations
+// come from a Barnes-Hut octree that is rebuilt every step: the particles are sorted along a Morton
+// curve, every octant of the root becomes its own subtree, and a cell whose size seen from a
+// particle is below the opening angle `theta` acts as a single mass at its centre of mass.
+// Bounding box, keys, sort, subtrees and forces all run on the mover's own WorkStealingPool of
+// Parameters::threads workers, a step costs O(N log N). theta = 0 opens every cell and gives the exact O(N^2) sum.
+// The mover keeps the velocities of its population, so it always has to be given the same
+// objects in the same order. It is not separable and not thread-safe.
+#include <cstdint>
+#include <limits>
+class BarnesHutMover final : public Mover {
+public:
+    struct Parameters {
+        double theta{0.5};
+        double dt{1e-3};
+        double mass{1.};          // per particle, with G = 1
+        double softening{1e-2};
+        std::size_t leaf_size{16};
+        std::size_t threads{std::thread::hardware_concurrency()};
+    };
+
+    BarnesHutMover() : BarnesHutMover{Parameters{}} {}
+    explicit BarnesHutMover(const Parameters& params)
+        : params_{params}, pool_{params.threads} {}
+
+    // a particle on its own feels no force
+    Vec GetNewCoords(const Vec& old) override { return old; }
+    void WhoAmI() override {
+        std::cout << "I am a Barnes-Hut mover\n";
+    }
+    const char* Name() const override { return "BarnesHutMover"; }
+    bool IsSeparable() const override { return false; }
+
+    void UpdateCoords(std::span<Vec> coords) override {
+        // objects added since the last step start at rest, the others keep their velocities
+        velocities_.resize(coords.size());
+        if (coords.empty())
+            return;
+        Sort(coords);
+        BuildTree();
+        ComputeAccelerations();
+        Integrate(coords);
+    }
+
+    // indexed like the coordinates passed to UpdateCoords, e.g. to set initial conditions
+    std::span<Vec> Velocities() { return velocities_; }
+    std::size_t TreeSize() const { return nodes_.size(); }
+
+private:
+    static constexpr int levels{21};  // 3 * 21 bits of Morton key
+    static constexpr std::uint32_t no_child{std::numeric_limits<std::uint32_t>::max()};
+
+    struct Node {
+        Vec com{};
+        double mass{0.};
+        double size{0.};  // edge length of the cell
+        std::uint32_t begin{0}, end{0};  // particles in Morton order
+        std::array<std::uint32_t, 8> child{no_child, no_child, no_child, no_child,
+                                           no_child, no_child, no_child, no_child};
+        bool leaf{true};
+    };
+
+    struct Keyed {
+        std::uint64_t key;
+        std::uint32_t index;
+        bool operator<(const Keyed& other) const { return key < other.key; }
+    };
+
+    // f(begin, end) on chunks of [0, n) spread over the pool
+    std::size_t Chunks(std::size_t n) const {
+        return std::min((n + min_grain - 1) / min_grain, 8 * pool_.size());
+    }
+
+    template <typename F>
+    void ParallelFor(std::size_t n, F&& f) {
+        const std::size_t count = Chunks(n);
+        pool_.run(count, [&](std::size_t task, std::size_t) {
+            f(task * n / count, (task + 1) * n / count);
+        });
+    }
+
+    // spreads the lowest 21 bits of v over every third bit
+    static std::uint64_t SpreadBits(std::uint64_t v) {
+        v &= 0x1fffff;
+        v = (v | v << 32) & 0x1f00000000ffffULL;
+        v = (v | v << 16) & 0x1f0000ff0000ffULL;
+        v = (v | v << 8) & 0x100f00f00f00f00fULL;
+        v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+        v = (v | v << 2) & 0x1249249249249249ULL;
+        return v;
+    }
+
+    void Sort(std::span<const Vec> coords) {
+        const std::size_t n = coords.size();
+        std::vector<std::array<Vec, 2>> boxes(Chunks(n));
+        std::atomic<std::size_t> next_box{0};
+        ParallelFor(n, [&](std::size_t begin, std::size_t end) {
+            auto& box = boxes[next_box.fetch_add(1, std::memory_order_relaxed)];
+            box = {coords[begin], coords[begin]};
+            for (std::size_t i = begin; i < end; ++i)
+                for (int d = 0; d < 3; ++d) {
+                    box[0][d] = std::min(box[0][d], coords[i][d]);
+                    box[1][d] = std::max(box[1][d], coords[i][d]);
+                }
+        });
+        lo_ = coords[0];
+        Vec hi = coords[0];
+        for (std::size_t b = 0; b < next_box.load(); ++b)
+            for (int d = 0; d < 3; ++d) {
+                lo_[d] = std::min(lo_[d], boxes[b][0][d]);
+                hi[d] = std::max(hi[d], boxes[b][1][d]);
+            }
+        size_ = std::max({hi[0] - lo_[0], hi[1] - lo_[1], hi[2] - lo_[2], 1e-12}) * (1. + 1e-9);
+
+        keyed_.resize(n);
+        const double scale = static_cast<double>(1 << levels) / size_;
+        ParallelFor(n, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                std::uint64_t key{0};
+                for (int d = 0; d < 3; ++d) {
+                    const auto q = static_cast<std::uint64_t>((coords[i][d] - lo_[d]) * scale);
+                    key |= SpreadBits(std::min<std::uint64_t>(q, (1 << levels) - 1)) << d;
+                }
+                keyed_[i] = {key, static_cast<std::uint32_t>(i)};
+            }
+            std::sort(keyed_.begin() + begin, keyed_.begin() + end);
+        });
+        // the chunks above are sorted, merge neighbours pairwise until one run is left
+        const std::size_t count = Chunks(n);
+        for (std::size_t width = 1; width < count; width *= 2) {
+            pool_.run((count + 2 * width - 1) / (2 * width), [&](std::size_t task, std::size_t) {
+                const std::size_t first = 2 * width * task;
+                const std::size_t mid = std::min(first + width, count);
+                const std::size_t last = std::min(first + 2 * width, count);
+                std::inplace_merge(keyed_.begin() + first * n / count, keyed_.begin() + mid * n / count,
+                                   keyed_.begin() + last * n / count);
+            });
+        }
+
+        sorted_.resize(n);
+        ParallelFor(n, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t k = begin; k < end; ++k)
+                sorted_[k] = coords[keyed_[k].index];
+        });
+    }
+
+    // builds the cell of particles [begin, end) at `level` into `out` and returns its index
+    std::uint32_t Build(std::vector<Node>& out, std::uint32_t begin, std::uint32_t end, int level) const {
+        const auto self = static_cast<std::uint32_t>(out.size());
+        out.push_back(Node{});
+        out[self].begin = begin;
+        out[self].end = end;
+        out[self].size = size_ / static_cast<double>(1 << level);
+        if (end - begin > params_.leaf_size && level < levels) {
+            const int shift = 3 * (levels - 1 - level);
+            out[self].leaf = false;
+            std::uint32_t first = begin;
+            for (std::uint64_t octant = 0; octant < 8 && first < end; ++octant) {
+                const auto last = static_cast<std::uint32_t>(
+                    std::partition_point(keyed_.begin() + first, keyed_.begin() + end,
+                                         [&](const Keyed& k) { return (k.key >> shift & 7) <= octant; }) -
+                    keyed_.begin());
+                if (last > first)
+                    out[self].child[octant] = Build(out, first, last, level + 1);
+                first = last;
+            }
+        }
+        Summarise(out, self);
+        return self;
+    }
+
+    // mass and centre of mass from the children, or from the particles of a leaf
+    void Summarise(std::vector<Node>& nodes, std::uint32_t index) const {
+        Node& node = nodes[index];
+        Vec weighted{};
+        if (node.leaf) {
+            for (std::uint32_t k = node.begin; k < node.end; ++k)
+                for (int d = 0; d < 3; ++d)
+                    weighted[d] += sorted_[k][d];
+            node.mass = params_.mass * (node.end - node.begin);
+            for (int d = 0; d < 3; ++d)
+                node.com[d] = weighted[d] / (node.end - node.begin);
+            return;
+        }
+        node.mass = 0.;
+        for (const auto c : node.child)
+            if (c != no_child) {
+                node.mass += nodes[c].mass;
+                for (int d = 0; d < 3; ++d)
+                    weighted[d] += nodes[c].mass * nodes[c].com[d];
+            }
+        for (int d = 0; d < 3; ++d)
+            node.com[d] = weighted[d] / node.mass;
+    }
+
+    void BuildTree() {
+        const auto n = static_cast<std::uint32_t>(keyed_.size());
+        nodes_.clear();
+        nodes_.push_back(Node{});
+        nodes_[0].end = n;
+        nodes_[0].size = size_;
+        if (n > params_.leaf_size) {
+            nodes_[0].leaf = false;
+            // the root octants are independent subtrees, one task each
+            std::array<std::uint32_t, 9> bounds{};
+            for (std::uint64_t octant = 0; octant < 8; ++octant)
+                bounds[octant + 1] = static_cast<std::uint32_t>(
+                    std::partition_point(keyed_.begin(), keyed_.end(),
+                                         [&](const Keyed& k) { return (k.key >> 3 * (levels - 1) & 7) <= octant; }) -
+                    keyed_.begin());
+            pool_.run(8, [&](std::size_t octant, std::size_t) {
+                subtrees_[octant].clear();
+                if (bounds[octant + 1] > bounds[octant])
+                    Build(subtrees_[octant], bounds[octant], bounds[octant + 1], 1);
+            });
+            for (std::size_t octant = 0; octant < 8; ++octant) {
+                if (subtrees_[octant].empty())
+                    continue;
+                const auto offset = static_cast<std::uint32_t>(nodes_.size());
+                nodes_[0].child[octant] = offset;
+                for (Node node : subtrees_[octant]) {
+                    for (auto& c : node.child)
+                        if (c != no_child)
+                            c += offset;
+                    nodes_.push_back(node);
+                }
+            }
+        }
+        Summarise(nodes_, 0);
+    }
+
+    void ComputeAccelerations() {
+        accelerations_.resize(sorted_.size());
+        const double theta2 = params_.theta * params_.theta;
+        const double eps2 = params_.softening * params_.softening;
+        ParallelFor(sorted_.size(), [&](std::size_t begin, std::size_t end) {
+            std::vector<std::uint32_t> stack;
+            for (std::size_t k = begin; k < end; ++k) {
+                const Vec& p = sorted_[k];
+                Vec a{};
+                const auto pull = [&](const Vec& at, double mass) {
+                    const Vec d{at[0] - p[0], at[1] - p[1], at[2] - p[2]};
+                    const double r2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2] + eps2;
+                    const double f = mass / (r2 * std::sqrt(r2));
+                    for (int i = 0; i < 3; ++i)
+                        a[i] += f * d[i];
+                };
+                stack.assign(1, 0);
+                while (!stack.empty()) {
+                    const Node& node = nodes_[stack.back()];
+                    stack.pop_back();
+                    if (node.leaf) {
+                        for (std::uint32_t j = node.begin; j < node.end; ++j)
+                            if (j != k)
+                                pull(sorted_[j], params_.mass);
+                        continue;
+                    }
+                    const Vec d{node.com[0] - p[0], node.com[1] - p[1], node.com[2] - p[2]};
+                    const double r2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+                    const bool inside = k >= node.begin && k < node.end;
+                    if (!inside && node.size * node.size < theta2 * r2) {
+                        pull(node.com, node.mass);
+                        continue;
+                    }
+                    for (const auto c : node.child)
+                        if (c != no_child)
+                            stack.push_back(c);
+                }
+                accelerations_[k] = a;
+            }
+        });
+    }
+
+    void Integrate(std::span<Vec> coords) {
+        ParallelFor(coords.size(), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t k = begin; k < end; ++k) {
+                const std::uint32_t i = keyed_[k].index;
+                for (int d = 0; d < 3; ++d) {
+                    velocities_[i][d] += params_.dt * accelerations_[k][d];
+                    coords[i][d] += params_.dt * velocities_[i][d];
+                }
+            }
+        });
+    }
+
+    static constexpr std::size_t min_grain{4096};
+
+    Parameters params_;
+    WorkStealingPool pool_;
+    std::vector<Vec> velocities_;
+    Vec lo_{};
+    double size_{0.};
+    std::vector<Keyed> keyed_;
+    std::vector<Vec> sorted_;
+    std::vector<Vec> accelerations_;
+    std::vector<Node> nodes_;
+    std::array<std::vector<Node>, 8> subtrees_;
+};
+
+#include <chrono>
+#include <string_view>
+void ThroughputReport(std::size_t simple, std::size_t orbit, int steps) {
+    const std::size_t max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (std::size_t threads = 1; threads <= max_threads; ++threads) {
+        MovingObjects objects;
+        for (std::size_t i = 0; i < simple; ++i)
+            objects.add<SimpleMover>();
+        for (std::size_t i = 0; i < orbit; ++i)
+            objects.add<OrbitMover>(Vec{1., 0., 0.});
+        ParallelStepper stepper{threads};
+        const auto start = std::chrono::steady_clock::now();
+        for (int s = 0; s < steps; ++s)
+            stepper.step(objects);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << threads << " thread(s): " << (simple + orbit) * steps / elapsed.count() / 1e6
+                  << " Mmoves/s\n";
+        stepper.report(std::cout);
+    }
+}
+
+// per-move cost of the inline policy against the runtime bridge, for the same SimpleMover
+void MoveCostReport(std::size_t count, int steps) {
+    const auto time_moves = [&](auto& objects, auto&& move) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int s = 0; s < steps; ++s)
+            for (auto& object : objects)
+                move(object);
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / (static_cast<double>(count) * steps);
+    };
+
+    std::vector<MovingObject<SimpleMover>> inline_objects(count);
+    std::vector<std::unique_ptr<Object>> dynamic_objects;
+    for (std::size_t i = 0; i < count; ++i)
+        dynamic_objects.push_back(std::make_unique<MovingObject<>>());
+
+    std::cout << "MovingObject<SimpleMover>:  " << time_moves(inline_objects, [](auto& o) { o.move(); })
+              << " ns/move (" << sizeof(MovingObject<SimpleMover>) << " bytes, no allocation)\n";
+    std::cout << "MovingObject<DynamicMover>: " << time_moves(dynamic_objects, [](auto& o) { o->move(); })
+              << " ns/move (" << sizeof(MovingObject<>) << " bytes + " << sizeof(SimpleMover)
+              << " bytes on the heap)\n";
+}
+
+#include <random>
+#include <string>
+std::vector<Vec> RandomCluster(std::size_t count, unsigned seed = 42) {
+    std::mt19937_64 rng{seed};
+    std::uniform_real_distribution<double> coord{-1., 1.};
+    std::vector<Vec> coords(count);
+    for (auto& c : coords)
+        c = {coord(rng), coord(rng), coord(rng)};
+    return coords;
+}
+
+// step time against N, and the force error of the opening angle against the exact sum
+void BarnesHutReport(std::size_t max_particles, int steps) {
+    constexpr std::size_t probe{4000};
+    std::vector<Vec> exact_coords = RandomCluster(probe);
+    std::vector<Vec> approx_coords = exact_coords;
+    BarnesHutMover exact{{.theta = 0.}};
+    exact.UpdateCoords(exact_coords);
+    for (const double theta : {0.3, 0.5, 0.8}) {
+        BarnesHutMover approx{{.theta = theta}};
+        approx_coords = RandomCluster(probe);
+        approx.UpdateCoords(approx_coords);
+        double error{0.}, norm{0.};
+        for (std::size_t i = 0; i < probe; ++i)
+            for (int d = 0; d < 3; ++d) {
+                const double diff = approx.Velocities()[i][d] - exact.Velocities()[i][d];
+                error += diff * diff;
+                norm += exact.Velocities()[i][d] * exact.Velocities()[i][d];
+            }
+        std::cout << "theta " << theta << ": rms force error " << std::sqrt(error / norm) << '\n';
+    }
+
+    for (std::size_t n = 10'000; n <= max_particles; n *= 10) {
+        std::vector<Vec> coords = RandomCluster(n);
+        BarnesHutMover mover;
+        mover.UpdateCoords(coords);
+        const auto start = std::chrono::steady_clock::now();
+        for (int s = 0; s < steps; ++s)
+            mover.UpdateCoords(coords);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        const double per_step = elapsed.count() / steps;
+        std::cout << n << " particles: " << per_step * 1e3 << " ms/step, "
+                  << per_step * 1e9 / (static_cast<double>(n) * std::log2(static_cast<double>(n)))
+                  << " ns per N log2 N, " << mover.TreeSize() << " cells\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
     MovingObject obj;
     obj.WhereAmI();
     obj.move();
     obj.WhereAmI();
+
+    MovingObject<SimpleMover> inline_obj;
+    inline_obj.move();
+    inline_obj.move();
+    inline_obj.WhereAmI();
+
+    // copies the object, then reports both kinds through the same const interface
+    MovingObject<SimpleMover> inline_copy{inline_obj};
+    inline_copy.move();
+    const auto report = [](const auto& object) { object.WhereAmI(); };
+    report(inline_copy);
+    report(obj);
+
+    MovingObjects objects;
+    for (int i = 0; i < 3; ++i)
+        objects.add<SimpleMover>(Vec{0., 1. * i, 2. * i});
+    objects.move();
+    objects.move();
+    objects.WhereAmI();
+
+    ParallelStepper stepper{2, 2};
+    objects.add<OrbitMover>(Vec{1., 0., 0.});
+    stepper.step(objects);
+    objects.WhereAmI();
+
+    MovingObjects cluster;
+    const std::vector<Vec> stars = RandomCluster(2000);
+    cluster.add<BarnesHutMover>(stars[0], BarnesHutMover::Parameters{.theta = 0.7, .softening = 5e-2, .threads = 2});
+    for (std::size_t i = 1; i < stars.size(); ++i)
+        cluster.add<BarnesHutMover>(stars[i]);
+    const auto centre = [&cluster] {
+        Vec com{};
+        cluster.for_each_group([&](Mover&, std::span<Vec> coords) {
+            for (const auto& c : coords)
+                for (int d = 0; d < 3; ++d)
+                    com[d] += c[d] / static_cast<double>(coords.size());
+        });
+        return com;
+    };
+    const Vec before = centre();
+    for (int s = 0; s < 10; ++s)
+        stepper.step(cluster);
+    const Vec after = centre();
+    std::cout << "Barnes-Hut cluster of " << cluster.size() << ", centre of mass moved by "
+              << std::hypot(after[0] - before[0], after[1] - before[1], after[2] - before[2]) << '\n';
+
+    // run with "bench" for the per-move cost, a throughput report from 1 to N threads and the
+    // Barnes-Hut scaling, "bench N" runs the latter up to N particles
+    if (argc > 1 && std::string_view{argv[1]} == "bench") {
+        MoveCostReport(1'000'000, 20);
+        ThroughputReport(4'000'000, 400'000, 10);
+        BarnesHutReport(argc > 2 ? std::stoul(argv[2]) : 100'000, 3);
+    }
+
+    trace::Dump(std::cout);
 }
+
+// compile with g++ --std=c++20 -O2 -pthread -o bridge Bridge.cpp
+// add -DBRIDGE_TRACE_LEVEL=1 for move counters and batch timings, 2 for the event log as well
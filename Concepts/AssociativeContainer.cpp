@@ -5,22 +5,17 @@
 #include <set>
 #include <iostream>
 
+// the lookup part, also met by containers that are filled once and never change
 template <typename T>
-concept AssociativeContainer =
+concept ReadOnlyAssociativeContainer =
     std::is_class_v<T> &&
-    std::regular<T> &&
+    std::copyable<T> &&
+    std::equality_comparable<T> &&
     requires {
         typename T::value_type;
         typename T::key_type;
-        typename T::iterator;
         typename T::const_iterator;
     } &&
-    requires(T cont, T::value_type value) {  // the typename keyword is optional in this context
-        { cont.begin() } -> std::same_as<typename T::iterator>;
-        { cont.end() } -> std::same_as<typename T::iterator>;
-        cont.insert(value);
-        cont.find(std::declval<typename T::key_type>());
-    } &&
     requires(T const cont) {
         { cont.size() } -> std::convertible_to<size_t>;  // or alternatively std::integral
         { cont.empty() } -> std::same_as<bool>;
@@ -28,6 +23,21 @@ concept AssociativeContainer =
         { cont.end() } -> std::same_as<typename T::const_iterator>;
         { cont.cbegin() } -> std::same_as<typename T::const_iterator>;
         { cont.cend() } -> std::same_as<typename T::const_iterator>;
+        cont.find(std::declval<typename T::key_type>());
+    };
+
+template <typename T>
+concept AssociativeContainer =
+    ReadOnlyAssociativeContainer<T> &&
+    std::regular<T> &&
+    requires {
+        typename T::iterator;
+    } &&
+    requires(T cont, T::value_type value) {  // the typename keyword is optional in this context
+        { cont.begin() } -> std::same_as<typename T::iterator>;
+        { cont.end() } -> std::same_as<typename T::iterator>;
+        cont.insert(value);
+        cont.find(std::declval<typename T::key_type>());
     };
 
 template <typename T>
@@ -36,6 +46,751 @@ struct IsAssociativeContainer : std::bool_constant<AssociativeContainer<T>> {};
 template <typename T>
 constexpr bool IsAssociativeContainer_v = IsAssociativeContainer<T>::value;
 
+// ---- flat_set.h ----
+// Sorted vectors with the interface of std::set and std::map. Elements are contiguous: lookups
+// are a branchless binary search over one array and there is no allocation per element, but a
+// single insert is O(n). Ranges should go through the bulk insert, which appends, sorts the new
+// elements, merges them in and drops duplicates. Like std::set, the first of equal keys is kept.
+// The keys of a flat_map can be modified through its iterators, which breaks the order.
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+namespace detail {
+// lower_bound whose loop the compiler turns into conditional moves
+template <typename It, typename K, typename Less>
+It lower_bound(It first, It last, const K& key, Less less) {
+    auto n = last - first;
+    if (n == 0)
+        return first;
+    while (n > 1) {
+        const auto half = n / 2;
+        first = less(first[half], key) ? first + half : first;
+        n -= half;
+    }
+    return first + less(*first, key);
+}
+
+// `sorted` skips sorting the new elements, which must then already be in order
+template <typename Container, typename It, typename KeyLess>
+void merge_unique(Container& elements, It first, It last, KeyLess less, bool sorted = false) {
+    const auto old_size = static_cast<std::ptrdiff_t>(elements.size());
+    elements.insert(elements.end(), first, last);
+    const auto middle = elements.begin() + old_size;
+    if (!sorted)
+        std::stable_sort(middle, elements.end(), less);
+    std::inplace_merge(elements.begin(), middle, elements.end(), less);
+    const auto equal = [&](const auto& a, const auto& b) { return !less(a, b); };  // sorted, so a <= b
+    elements.erase(std::unique(elements.begin(), elements.end(), equal), elements.end());
+}
+}  // namespace detail
+
+// tags a range as sorted by the container's order, with no duplicates, like C++23's std::sorted_unique
+struct sorted_unique_t {
+    explicit sorted_unique_t() = default;
+};
+inline constexpr sorted_unique_t sorted_unique{};
+
+template <typename Key, typename Compare = std::less<Key>>
+class flat_set {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using size_type = std::size_t;
+    using iterator = typename std::vector<Key>::const_iterator;  // like std::set, elements are const
+    using const_iterator = typename std::vector<Key>::const_iterator;
+
+    flat_set() = default;
+
+    template <std::input_iterator It>
+    flat_set(It first, It last) { insert(first, last); }
+
+    flat_set(std::initializer_list<Key> init) { insert(init.begin(), init.end()); }
+
+    iterator begin() const { return elements_.cbegin(); }
+    iterator end() const { return elements_.cend(); }
+    const_iterator cbegin() const { return elements_.cbegin(); }
+    const_iterator cend() const { return elements_.cend(); }
+
+    size_type size() const { return elements_.size(); }
+    bool empty() const { return elements_.empty(); }
+    void reserve(size_type n) { elements_.reserve(n); }
+    void clear() { elements_.clear(); }
+
+    std::pair<iterator, bool> insert(const Key& key) { return emplace_at(key); }
+    std::pair<iterator, bool> insert(Key&& key) { return emplace_at(std::move(key)); }
+
+    template <std::input_iterator It>
+    void insert(It first, It last) {
+        detail::merge_unique(elements_, first, last, Compare{});
+    }
+
+    template <std::input_iterator It>
+    void insert(sorted_unique_t, It first, It last) {
+        detail::merge_unique(elements_, first, last, Compare{}, true);
+    }
+
+    key_compare key_comp() const { return {}; }
+    value_compare value_comp() const { return {}; }
+
+    iterator lower_bound(const Key& key) const {
+        return detail::lower_bound(elements_.cbegin(), elements_.cend(), key, Compare{});
+    }
+
+    iterator find(const Key& key) const {
+        const auto it = lower_bound(key);
+        return it != end() && !Compare{}(key, *it) ? it : end();
+    }
+
+    bool contains(const Key& key) const { return find(key) != end(); }
+    size_type count(const Key& key) const { return contains(key); }
+
+    size_type erase(const Key& key) {
+        const auto it = find(key);
+        if (it == end())
+            return 0;
+        elements_.erase(it);
+        return 1;
+    }
+
+    friend bool operator==(const flat_set&, const flat_set&) = default;
+
+private:
+    template <typename K>
+    std::pair<iterator, bool> emplace_at(K&& key) {
+        const auto it = lower_bound(key);
+        if (it != end() && !Compare{}(key, *it))
+            return {it, false};
+        return {elements_.insert(it, std::forward<K>(key)), true};
+    }
+
+    std::vector<Key> elements_;
+};
+
+// ---- flat_map.h ----
+template <typename Key, typename T, typename Compare = std::less<Key>>
+class flat_map {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using key_compare = Compare;
+    using size_type = std::size_t;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    flat_map() = default;
+
+    template <std::input_iterator It>
+    flat_map(It first, It last) { insert(first, last); }
+
+    flat_map(std::initializer_list<value_type> init) { insert(init.begin(), init.end()); }
+
+    iterator begin() { return elements_.begin(); }
+    iterator end() { return elements_.end(); }
+    const_iterator begin() const { return elements_.cbegin(); }
+    const_iterator end() const { return elements_.cend(); }
+    const_iterator cbegin() const { return elements_.cbegin(); }
+    const_iterator cend() const { return elements_.cend(); }
+
+    size_type size() const { return elements_.size(); }
+    bool empty() const { return elements_.empty(); }
+    void reserve(size_type n) { elements_.reserve(n); }
+    void clear() { elements_.clear(); }
+
+    std::pair<iterator, bool> insert(const value_type& value) { return try_emplace(value.first, value.second); }
+    std::pair<iterator, bool> insert(value_type&& value) {
+        return try_emplace(std::move(value.first), std::move(value.second));
+    }
+
+    template <std::input_iterator It>
+    void insert(It first, It last) {
+        detail::merge_unique(elements_, first, last, value_compare{});
+    }
+
+    template <std::input_iterator It>
+    void insert(sorted_unique_t, It first, It last) {
+        detail::merge_unique(elements_, first, last, value_compare{}, true);
+    }
+
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+        const auto it = lower_bound(key);
+        if (it != end() && !Compare{}(key, it->first))
+            return {it, false};
+        return {elements_.emplace(it, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                                  std::forward_as_tuple(std::forward<Args>(args)...)),
+                true};
+    }
+
+    T& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+    iterator lower_bound(const Key& key) {
+        return detail::lower_bound(elements_.begin(), elements_.end(), key, value_compare{});
+    }
+    const_iterator lower_bound(const Key& key) const {
+        return detail::lower_bound(elements_.cbegin(), elements_.cend(), key, value_compare{});
+    }
+
+    iterator find(const Key& key) {
+        const auto it = lower_bound(key);
+        return it != end() && !Compare{}(key, it->first) ? it : end();
+    }
+    const_iterator find(const Key& key) const {
+        const auto it = lower_bound(key);
+        return it != end() && !Compare{}(key, it->first) ? it : end();
+    }
+
+    bool contains(const Key& key) const { return find(key) != end(); }
+    size_type count(const Key& key) const { return contains(key); }
+
+    size_type erase(const Key& key) {
+        const auto it = find(key);
+        if (it == end())
+            return 0;
+        elements_.erase(it);
+        return 1;
+    }
+
+    friend bool operator==(const flat_map&, const flat_map&) = default;
+
+    // orders elements by key, and elements against plain keys for the binary search
+    struct value_compare {
+        bool operator()(const value_type& a, const value_type& b) const { return Compare{}(a.first, b.first); }
+        bool operator()(const value_type& a, const Key& b) const { return Compare{}(a.first, b); }
+    };
+
+    key_compare key_comp() const { return {}; }
+    value_compare value_comp() const { return {}; }
+
+private:
+    std::vector<value_type> elements_;
+};
+
+static_assert(AssociativeContainer<flat_set<int>>);
+static_assert(AssociativeContainer<flat_map<int, double>>);
+
+// ---- swiss_table.h ----
+// Open addressing hash set and map in the style of Abseil's Swiss tables. Every slot has a
+// control byte, either empty, deleted, or the low 7 bits of the hash of its key. The table is
+// probed a group of 16 control bytes at a time: one SSE2 compare yields all candidate slots of a
+// group, so almost every lookup touches a single group and compares at most one key. Groups are
+// visited in triangular order and the table keeps at least 1/8 of its slots empty, which ends
+// every probe. The capacity is a power of two, reserve(n) makes room for n elements at once.
+#include <bit>
+#include <cstdint>
+#include <memory>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace detail {
+class ControlGroup {
+public:
+    static constexpr std::size_t width{16};
+    static constexpr std::int8_t empty{-128};
+    static constexpr std::int8_t deleted{-2};
+
+    explicit ControlGroup(const std::int8_t* ctrl) {
+#if defined(__SSE2__)
+        bytes_ = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+        std::copy_n(ctrl, width, bytes_);
+#endif
+    }
+
+    // bit i is set if control byte i equals `h2`, empty or, for the last one, has its top bit set
+    std::uint32_t match(std::int8_t h2) const { return mask_equal(h2); }
+    std::uint32_t match_empty() const { return mask_equal(empty); }
+    std::uint32_t match_empty_or_deleted() const {
+#if defined(__SSE2__)
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(bytes_));
+#else
+        std::uint32_t mask{0};
+        for (std::size_t i = 0; i < width; ++i)
+            mask |= std::uint32_t{bytes_[i] < 0} << i;
+        return mask;
+#endif
+    }
+
+private:
+    std::uint32_t mask_equal(std::int8_t value) const {
+#if defined(__SSE2__)
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes_, _mm_set1_epi8(value))));
+#else
+        std::uint32_t mask{0};
+        for (std::size_t i = 0; i < width; ++i)
+            mask |= std::uint32_t{bytes_[i] == value} << i;
+        return mask;
+#endif
+    }
+
+#if defined(__SSE2__)
+    __m128i bytes_;
+#else
+    std::int8_t bytes_[width];
+#endif
+};
+
+// Value is Key for a set and std::pair<const Key, T> for a map
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+class swiss_table {
+    static constexpr bool is_set = std::same_as<Key, Value>;
+
+public:
+    using key_type = Key;
+    using value_type = Value;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+
+    template <bool Const>
+    class basic_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Value;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const Value*, Value*>;
+        using reference = std::conditional_t<Const, const Value&, Value&>;
+
+        basic_iterator() = default;
+        basic_iterator(const std::int8_t* ctrl, Value* slots, size_type index, size_type capacity)
+            : ctrl_{ctrl}, slots_{slots}, index_{index}, capacity_{capacity} {
+            skip_free();
+        }
+        // iterator to const_iterator
+        template <bool C> requires (Const && !C)
+        basic_iterator(const basic_iterator<C>& other)
+            : ctrl_{other.ctrl_}, slots_{other.slots_}, index_{other.index_}, capacity_{other.capacity_} {}
+
+        reference operator*() const { return slots_[index_]; }
+        pointer operator->() const { return slots_ + index_; }
+        basic_iterator& operator++() {
+            ++index_;
+            skip_free();
+            return *this;
+        }
+        basic_iterator operator++(int) {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.index_ == b.index_; }
+
+    private:
+        template <bool> friend class basic_iterator;
+        friend class swiss_table;
+
+        void skip_free() {
+            while (index_ < capacity_ && ctrl_[index_] < 0)
+                ++index_;
+        }
+
+        const std::int8_t* ctrl_{nullptr};
+        Value* slots_{nullptr};
+        size_type index_{0};
+        size_type capacity_{0};
+    };
+
+    using iterator = basic_iterator<is_set>;  // like std::set, the elements of a set are const
+    using const_iterator = basic_iterator<true>;
+
+    swiss_table() = default;
+
+    swiss_table(const swiss_table& other) {
+        reserve(other.size());
+        for (const auto& value : other)
+            insert(value);
+    }
+
+    swiss_table(swiss_table&& other) noexcept
+        : ctrl_{std::move(other.ctrl_)},
+          slots_{std::exchange(other.slots_, nullptr)},
+          capacity_{std::exchange(other.capacity_, 0)},
+          size_{std::exchange(other.size_, 0)},
+          growth_left_{std::exchange(other.growth_left_, 0)} {}
+
+    swiss_table& operator=(swiss_table other) noexcept {
+        swap(*this, other);
+        return *this;
+    }
+
+    ~swiss_table() {
+        clear();
+        std::allocator<Value>{}.deallocate(slots_, capacity_);
+    }
+
+    friend void swap(swiss_table& a, swiss_table& b) noexcept {
+        using std::swap;
+        swap(a.ctrl_, b.ctrl_);
+        swap(a.slots_, b.slots_);
+        swap(a.capacity_, b.capacity_);
+        swap(a.size_, b.size_);
+        swap(a.growth_left_, b.growth_left_);
+    }
+
+    iterator begin() { return {ctrl_.get(), slots_, 0, capacity_}; }
+    iterator end() { return {ctrl_.get(), slots_, capacity_, capacity_}; }
+    const_iterator begin() const { return {ctrl_.get(), slots_, 0, capacity_}; }
+    const_iterator end() const { return {ctrl_.get(), slots_, capacity_, capacity_}; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    size_type size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    // elements that fit before the next rehash
+    size_type capacity() const { return size_ + growth_left_; }
+
+    void reserve(size_type count) {
+        if (count > capacity())
+            rehash(slots_for(count));
+    }
+
+    void clear() {
+        for (size_type i = 0; i < capacity_; ++i)
+            if (ctrl_[i] >= 0)
+                std::destroy_at(slots_ + i);
+        std::fill_n(ctrl_.get(), capacity_, ControlGroup::empty);
+        size_ = 0;
+        growth_left_ = max_load(capacity_);
+    }
+
+    std::pair<iterator, bool> insert(const Value& value) { return emplace_key(key_of(value), value); }
+    std::pair<iterator, bool> insert(Value&& value) { return emplace_key(key_of(value), std::move(value)); }
+
+    template <std::input_iterator It>
+    void insert(It first, It last) {
+        if constexpr (std::forward_iterator<It>)
+            reserve(size_ + static_cast<size_type>(std::distance(first, last)));
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) requires (!is_set) {
+        return emplace_key(key, std::piecewise_construct, std::forward_as_tuple(key),
+                           std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    auto& operator[](const Key& key) requires (!is_set) { return try_emplace(key).first->second; }
+
+    iterator find(const Key& key) { return at(find_index(key, hash(key))); }
+    const_iterator find(const Key& key) const { return at(find_index(key, hash(key))); }
+    bool contains(const Key& key) const { return find_index(key, hash(key)) != npos; }
+    size_type count(const Key& key) const { return contains(key); }
+
+    size_type erase(const Key& key) {
+        const size_type i = find_index(key, hash(key));
+        if (i == npos)
+            return 0;
+        std::destroy_at(slots_ + i);
+        --size_;
+        // probes end in a group with an empty slot, so one more cannot cut any of them short
+        const size_type group = i & ~(ControlGroup::width - 1);
+        if (ControlGroup{ctrl_.get() + group}.match_empty()) {
+            ctrl_[i] = ControlGroup::empty;
+            ++growth_left_;
+        } else {
+            ctrl_[i] = ControlGroup::deleted;
+        }
+        return 1;
+    }
+
+    friend bool operator==(const swiss_table& a, const swiss_table& b) {
+        if (a.size() != b.size())
+            return false;
+        for (const auto& value : a) {
+            const auto it = b.find(key_of(value));
+            if (it == b.end() || !(*it == value))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_type npos{~size_type{0}};
+
+    static const Key& key_of(const Value& value) {
+        if constexpr (is_set)
+            return value;
+        else
+            return value.first;
+    }
+
+    // std::hash of integers is the identity, so spread the bits before splitting the hash
+    static std::uint64_t hash(const Key& key) {
+        const std::uint64_t h = static_cast<std::uint64_t>(Hash{}(key)) * 0x9e3779b97f4a7c15ull;
+        return h ^ (h >> 32);
+    }
+    static std::int8_t h2(std::uint64_t h) { return static_cast<std::int8_t>(h & 0x7f); }
+
+    static size_type max_load(size_type slots) { return slots - slots / 8; }
+    static size_type slots_for(size_type count) {
+        size_type slots{ControlGroup::width};
+        while (max_load(slots) < count)
+            slots *= 2;
+        return slots;
+    }
+
+    iterator at(size_type i) const {
+        return {ctrl_.get(), slots_, i == npos ? capacity_ : i, capacity_};
+    }
+
+    size_type find_index(const Key& key, std::uint64_t h) const {
+        if (capacity_ == 0)
+            return npos;
+        const size_type mask = capacity_ / ControlGroup::width - 1;
+        size_type group = (h >> 7) & mask;
+        for (size_type step = 1;; ++step) {
+            const ControlGroup control{ctrl_.get() + group * ControlGroup::width};
+            for (auto m = control.match(h2(h)); m != 0; m &= m - 1) {
+                const size_type i = group * ControlGroup::width + static_cast<size_type>(std::countr_zero(m));
+                if (KeyEqual{}(key_of(slots_[i]), key))
+                    return i;
+            }
+            if (control.match_empty())
+                return npos;
+            group = (group + step) & mask;
+        }
+    }
+
+    // first empty or deleted slot on the probe sequence of `h`
+    size_type free_index(std::uint64_t h) const {
+        const size_type mask = capacity_ / ControlGroup::width - 1;
+        size_type group = (h >> 7) & mask;
+        for (size_type step = 1;; ++step) {
+            const auto m = ControlGroup{ctrl_.get() + group * ControlGroup::width}.match_empty_or_deleted();
+            if (m != 0)
+                return group * ControlGroup::width + static_cast<size_type>(std::countr_zero(m));
+            group = (group + step) & mask;
+        }
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace_key(const Key& key, Args&&... args) {
+        const std::uint64_t h = hash(key);
+        if (const size_type i = find_index(key, h); i != npos)
+            return {at(i), false};
+        if (growth_left_ == 0)
+            // tombstones are reclaimed in place, the table only grows when it is really full
+            rehash(size_ < max_load(capacity_) / 2 ? std::max(capacity_, ControlGroup::width) : slots_for(size_ + 1));
+        const size_type i = free_index(h);
+        if (ctrl_[i] == ControlGroup::empty)
+            --growth_left_;
+        std::construct_at(slots_ + i, std::forward<Args>(args)...);
+        ctrl_[i] = h2(h);
+        ++size_;
+        return {at(i), true};
+    }
+
+    void rehash(size_type slots) {
+        auto old_ctrl = std::exchange(ctrl_, std::make_unique<std::int8_t[]>(slots));
+        Value* old_slots = std::exchange(slots_, std::allocator<Value>{}.allocate(slots));
+        const size_type old_capacity = std::exchange(capacity_, slots);
+        std::fill_n(ctrl_.get(), capacity_, ControlGroup::empty);
+        growth_left_ = max_load(capacity_) - size_;
+        for (size_type i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] < 0)
+                continue;
+            const std::uint64_t h = hash(key_of(old_slots[i]));
+            const size_type j = free_index(h);
+            std::construct_at(slots_ + j, std::move(old_slots[i]));
+            std::destroy_at(old_slots + i);
+            ctrl_[j] = h2(h);
+        }
+        std::allocator<Value>{}.deallocate(old_slots, old_capacity);
+    }
+
+    std::unique_ptr<std::int8_t[]> ctrl_;
+    Value* slots_{nullptr};
+    size_type capacity_{0};
+    size_type size_{0};
+    size_type growth_left_{0};
+};
+}  // namespace detail
+
+template <typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+using swiss_set = detail::swiss_table<Key, Key, Hash, KeyEqual>;
+
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+using swiss_map = detail::swiss_table<Key, std::pair<const Key, T>, Hash, KeyEqual>;
+
+static_assert(AssociativeContainer<swiss_set<int>>);
+static_assert(AssociativeContainer<swiss_map<int, double>>);
+
+// ---- frozen_map.h ----
+// Sets and maps fixed at compile time. The constructor builds a perfect hash: the keys are split
+// into buckets by one hash, and every bucket gets a seed for a second hash that sends its keys to
+// slots no other key uses. It runs in constant evaluation, where a key that appears twice
+// fails to compile. A lookup is two hashes, two loads and a single key compare, with no probing
+// and no allocation. Keys can be integers, enums or string_views.
+#include <array>
+#include <stdexcept>
+#include <string_view>
+
+template <typename Key>
+struct frozen_hash {
+    constexpr std::uint64_t operator()(const Key& key) const {
+        if constexpr (std::is_enum_v<Key>)
+            return static_cast<std::uint64_t>(key);
+        else if constexpr (std::is_integral_v<Key>)
+            return static_cast<std::uint64_t>(key);
+        else {
+            std::uint64_t h{0xcbf29ce484222325ull};  // FNV-1a
+            for (const char c : std::string_view{key}) {
+                h ^= static_cast<unsigned char>(c);
+                h *= 0x100000001b3ull;
+            }
+            return h;
+        }
+    }
+};
+
+namespace detail {
+constexpr std::uint64_t mix(std::uint64_t h) {
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;  // splitmix64 finaliser
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
+}
+
+// slot of a mixed hash under a seed, one multiplication keeping the top bits
+template <std::size_t Slots>
+constexpr std::size_t seeded_slot(std::uint64_t mixed, std::uint64_t seed) {
+    if constexpr (Slots == 1)
+        return 0;
+    else
+        return static_cast<std::size_t>(((mixed ^ seed) * 0x9e3779b97f4a7c15ull) >> (64 - std::countr_zero(Slots)));
+}
+
+// Value is Key for a set and std::pair<Key, T> for a map
+template <typename Key, typename Value, std::size_t N, typename Hash>
+class frozen_table {
+    static constexpr bool is_set = std::same_as<Key, Value>;
+    static constexpr std::size_t slots{std::bit_ceil(std::max<std::size_t>(N, 1))};
+    static constexpr std::size_t mask{slots - 1};
+
+public:
+    using key_type = Key;
+    using value_type = Value;
+    using size_type = std::size_t;
+    using const_iterator = const Value*;
+
+    constexpr explicit frozen_table(const std::array<Value, N>& values) : values_{values} {
+        // bucket the keys by the first hash, biggest buckets first while most slots are free
+        std::array<std::size_t, N> order{};
+        std::array<std::size_t, slots> bucket_size{};
+        for (std::size_t i = 0; i < N; ++i) {
+            order[i] = i;
+            ++bucket_size[bucket(key_of(values_[i]))];
+            for (std::size_t j = 0; j < i; ++j)
+                if (key_of(values_[j]) == key_of(values_[i]))
+                    throw std::invalid_argument("frozen_table: duplicate key");
+        }
+        std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+            const auto ba = bucket(key_of(values_[a])), bb = bucket(key_of(values_[b]));
+            return bucket_size[ba] != bucket_size[bb] ? bucket_size[ba] > bucket_size[bb] : ba < bb;
+        });
+
+        std::array<bool, slots> taken{};
+        for (std::size_t first = 0; first < N;) {
+            const std::size_t b = bucket(key_of(values_[order[first]]));
+            const std::size_t last = first + bucket_size[b];
+            for (std::uint64_t seed = 1;; ++seed) {
+                if (seed > 1'000'000)
+                    throw std::logic_error("frozen_table: no perfect hash found");
+                std::array<std::size_t, N> slot_of{};
+                bool fits = true;
+                for (std::size_t i = first; i < last && fits; ++i) {
+                    slot_of[i] = seeded_slot<slots>(mix(Hash{}(key_of(values_[order[i]]))), seed);
+                    fits = !taken[slot_of[i]];
+                    for (std::size_t j = first; j < i && fits; ++j)
+                        fits = slot_of[j] != slot_of[i];
+                }
+                if (!fits)
+                    continue;
+                seeds_[b] = static_cast<std::uint32_t>(seed);
+                for (std::size_t i = first; i < last; ++i) {
+                    taken[slot_of[i]] = true;
+                    index_[slot_of[i]] = static_cast<std::uint32_t>(order[i]);
+                }
+                break;
+            }
+            first = last;
+        }
+    }
+
+    constexpr const_iterator begin() const { return values_.data(); }
+    constexpr const_iterator end() const { return values_.data() + N; }
+    constexpr const_iterator cbegin() const { return begin(); }
+    constexpr const_iterator cend() const { return end(); }
+    constexpr size_type size() const { return N; }
+    constexpr bool empty() const { return N == 0; }
+
+    constexpr const_iterator find(const Key& key) const {
+        if constexpr (N == 0) {
+            return end();
+        } else {
+            const std::uint64_t h = mix(Hash{}(key));
+            const std::uint32_t i = index_[seeded_slot<slots>(h, seeds_[h & mask])];
+            return key_of(values_[i]) == key ? begin() + i : end();
+        }
+    }
+
+    constexpr bool contains(const Key& key) const { return find(key) != end(); }
+    constexpr size_type count(const Key& key) const { return contains(key); }
+
+    constexpr const auto& at(const Key& key) const requires (!is_set) {
+        const auto it = find(key);
+        if (it == end())
+            throw std::out_of_range("frozen_map::at: unknown key");
+        return it->second;
+    }
+
+    friend constexpr bool operator==(const frozen_table& a, const frozen_table& b) {
+        for (const auto& value : a)
+            if (const auto it = b.find(key_of(value)); it == b.end() || !(*it == value))
+                return false;
+        return true;
+    }
+
+private:
+    static constexpr const Key& key_of(const Value& value) {
+        if constexpr (is_set)
+            return value;
+        else
+            return value.first;
+    }
+    static constexpr std::size_t bucket(const Key& key) { return mix(Hash{}(key)) & mask; }
+
+    std::array<Value, N> values_;
+    std::array<std::uint32_t, slots> seeds_{};
+    std::array<std::uint32_t, slots> index_{};  // slots no key hashes to point anywhere
+};
+}  // namespace detail
+
+template <typename Key, std::size_t N, typename Hash = frozen_hash<Key>>
+using frozen_set = detail::frozen_table<Key, Key, N, Hash>;
+
+template <typename Key, typename T, std::size_t N, typename Hash = frozen_hash<Key>>
+using frozen_map = detail::frozen_table<Key, std::pair<Key, T>, N, Hash>;
+
+template <typename Key, std::size_t N>
+constexpr auto make_frozen_set(const Key (&keys)[N]) {
+    return frozen_set<Key, N>{std::to_array(keys)};
+}
+
+template <typename Key, typename T, std::size_t N>
+constexpr auto make_frozen_map(const std::pair<Key, T> (&values)[N]) {
+    return frozen_map<Key, T, N>{std::to_array(values)};
+}
+
+static_assert(ReadOnlyAssociativeContainer<frozen_set<int, 4>>);
+static_assert(ReadOnlyAssociativeContainer<frozen_map<std::string_view, int, 4>>);
+static_assert(!AssociativeContainer<frozen_set<int, 4>>);
+
 // template<typename T, typename V>
 // std::enable_if_t<!IsAssociativeContainer_v<T>> addElement(T& container, const V& value) {
 //     std::cout << "Adding to Container\n";
@@ -61,6 +816,136 @@ void addElement(T& container, const V& value) {
     container.insert(value);
 }
 
+// containers that can tell how many elements fit before they reallocate, like swiss_set
+template <typename T>
+concept ReservableAssociativeContainer =
+    AssociativeContainer<T> &&
+    requires(T cont, std::size_t n) {
+        cont.reserve(n);
+        { cont.capacity() } -> std::convertible_to<std::size_t>;
+    };
+
+// after a reserve(n), n additions never rehash. Beyond that the capacity doubles up front,
+// so growth happens here rather than somewhere inside insert.
+template <typename T, typename V>
+    requires ReservableAssociativeContainer<T>
+void addElement(T& container, const V& value) {
+    std::cout << "Adding to Reservable Associative Container\n";
+    if (container.size() >= container.capacity())
+        container.reserve(2 * container.size() + 1);
+    container.insert(value);
+}
+
+// ---- addElements ----
+// Adds a whole range with one call, the overload is picked by what the container supports.
+// Sequences reserve up front when they can, hashed containers too, and ordered containers get
+// sorted input appended in O(1) per element (or merged in one pass for flat ones).
+// Compile with -DADD_ELEMENTS_TRACE=1 to log the chosen path.
+#ifndef ADD_ELEMENTS_TRACE
+#define ADD_ELEMENTS_TRACE 0
+#endif
+#include <ranges>
+
+namespace detail {
+template <typename R>
+void trace_add(const char* path, R&& range) {
+    if constexpr (ADD_ELEMENTS_TRACE) {
+        std::cout << "Adding ";
+        if constexpr (std::ranges::sized_range<R>)
+            std::cout << std::ranges::size(range) << ' ';
+        std::cout << "elements to " << path << '\n';
+    }
+}
+
+// inserts through the iterator pair interface, or insert_range where it exists (C++23)
+template <typename T, typename R>
+void insert_all(T& container, R&& range) {
+    if constexpr (requires { container.insert_range(std::forward<R>(range)); }) {
+        container.insert_range(std::forward<R>(range));
+    } else {
+        auto common = std::views::common(std::forward<R>(range));
+        container.insert(std::ranges::begin(common), std::ranges::end(common));
+    }
+}
+}  // namespace detail
+
+template <typename T>
+concept SequenceContainer = requires(T cont, typename T::value_type value) {
+    cont.push_back(value);
+};
+
+template <typename T>
+concept ReservableSequenceContainer =
+    SequenceContainer<T> &&
+    requires(T cont, std::size_t n) {
+        cont.reserve(n);
+        cont.insert(cont.end(), cont.begin(), cont.end());
+    };
+
+// containers that expose their order, like std::set and flat_set
+template <typename T>
+concept OrderedAssociativeContainer =
+    AssociativeContainer<T> &&
+    requires(T cont, typename T::value_type value) {
+        { cont.value_comp()(value, value) } -> std::convertible_to<bool>;
+    };
+
+template <SequenceContainer T, std::ranges::input_range R>
+void addElements(T& container, R&& range) {
+    detail::trace_add("Container", range);
+    for (auto&& value : range)
+        container.push_back(std::forward<decltype(value)>(value));
+}
+
+template <ReservableSequenceContainer T, std::ranges::input_range R>
+void addElements(T& container, R&& range) {
+    detail::trace_add("Reservable Container", range);
+    if constexpr (std::ranges::sized_range<R>)
+        container.reserve(container.size() + std::ranges::size(range));
+    auto common = std::views::common(std::forward<R>(range));
+    container.insert(container.end(), std::ranges::begin(common), std::ranges::end(common));
+}
+
+template <AssociativeContainer T, std::ranges::input_range R>
+void addElements(T& container, R&& range) {
+    detail::trace_add("Associative Container", range);
+    detail::insert_all(container, std::forward<R>(range));
+}
+
+template <OrderedAssociativeContainer T, std::ranges::forward_range R>
+void addElements(T& container, R&& range) {
+    const auto comp = container.value_comp();
+    if (!std::ranges::is_sorted(range, comp)) {
+        detail::trace_add("Ordered Associative Container", range);
+        detail::insert_all(container, std::forward<R>(range));
+        return;
+    }
+    detail::trace_add("Ordered Associative Container, sorted", range);
+    if constexpr (requires { container.insert(sorted_unique, std::ranges::begin(range), std::ranges::begin(range)); }) {
+        // one merge pass, duplicates within the range are dropped there as well
+        auto common = std::views::common(range);
+        container.insert(sorted_unique, std::ranges::begin(common), std::ranges::end(common));
+    } else {
+        // each element goes right before end(), which is O(1) while the range extends the container
+        for (auto&& value : range)
+            container.insert(container.end(), std::forward<decltype(value)>(value));
+    }
+}
+
+template <ReservableAssociativeContainer T, std::ranges::input_range R>
+void addElements(T& container, R&& range) {
+    detail::trace_add("Reservable Associative Container", range);
+    if constexpr (std::ranges::sized_range<R>)
+        container.reserve(container.size() + std::ranges::size(range));
+    detail::insert_all(container, std::forward<R>(range));
+}
+
+// for the elements of maps
+template <typename K, typename V>
+std::ostream& operator<<(std::ostream& os, const std::pair<K, V>& element) {
+    return os << element.first << ':' << element.second;
+}
+
 template <typename T>
 void print(T const& container) {
     std::cout << "\n (";
@@ -70,19 +955,207 @@ void print(T const& container) {
     std::cout << " )\n\n";
 }
 
-int main() {
+#include <chrono>
+#include <random>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+// build and lookup time of std::set against flat_set, half of the lookups miss
+void bench_lookup(std::size_t max_keys) {
+    std::mt19937_64 rng{7};
+    std::cout << "keys\t\tbuild set/flat [ms]\tfind set/flat [ns]\n";
+    for (std::size_t n = 10; n <= max_keys; n *= 10) {
+        std::vector<long> keys(n);
+        for (auto& k : keys)
+            k = static_cast<long>(rng() >> 2) * 2;  // even keys, odd ones miss
+        std::vector<long> queries(1'000'000);
+        for (auto& q : queries)
+            q = keys[rng() % n] + static_cast<long>(rng() & 1);
+
+        const auto time_ms = [](auto&& f) {
+            const auto start = std::chrono::steady_clock::now();
+            f();
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        };
+        std::set<long> tree;
+        flat_set<long> flat;
+        const double build_tree = time_ms([&] { tree.insert(keys.begin(), keys.end()); });
+        const double build_flat = time_ms([&] { flat.insert(keys.begin(), keys.end()); });
+        std::size_t hits{0};
+        const double find_tree = time_ms([&] {
+            for (const auto q : queries)
+                hits += tree.find(q) != tree.end();
+        });
+        const double find_flat = time_ms([&] {
+            for (const auto q : queries)
+                hits += flat.find(q) != flat.end();
+        });
+        const double per_query = 1e6 / static_cast<double>(queries.size());
+        std::cout << n << "\t\t" << build_tree << " / " << build_flat << "\t\t" << find_tree * per_query
+                  << " / " << find_flat * per_query << "\t(" << hits << " hits)\n";
+    }
+}
+
+// insert, successful and failing find per element, for the ordered and the hashed sets
+void bench_hash(std::size_t max_keys) {
+    std::mt19937_64 rng{11};
+    const auto ns_per = [](std::size_t count, auto&& f) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+               static_cast<double>(count);
+    };
+    std::cout << "keys\t\tset\t\t\tunordered_set\t\tswiss_set\t\tswiss_set+reserve\n"
+              << "\t\tinsert/hit/miss [ns]\n";
+    for (std::size_t n = 1'000; n <= max_keys; n *= 10) {
+        std::vector<long> keys(n), misses(n);
+        for (auto& k : keys)
+            k = static_cast<long>(rng() >> 2) * 2;
+        for (auto& k : misses)
+            k = static_cast<long>(rng() >> 2) * 2 + 1;
+        std::vector<long> hits = keys;
+        std::shuffle(hits.begin(), hits.end(), rng);
+
+        std::size_t found{0};
+        const auto run = [&](auto set, bool reserve) {
+            const double insert = ns_per(n, [&] {
+                if constexpr (requires { set.reserve(n); }) {
+                    if (reserve)
+                        set.reserve(n);
+                }
+                for (const auto k : keys)
+                    set.insert(k);
+            });
+            const double hit = ns_per(n, [&] {
+                for (const auto k : hits)
+                    found += set.find(k) != set.end();
+            });
+            const double miss = ns_per(n, [&] {
+                for (const auto k : misses)
+                    found += set.find(k) != set.end();
+            });
+            std::cout << insert << '/' << hit << '/' << miss << "\t";
+        };
+        std::cout << n << "\t\t";
+        run(std::set<long>{}, false);
+        run(std::unordered_set<long>{}, false);
+        run(swiss_set<long>{}, false);
+        run(swiss_set<long>{}, true);
+        std::cout << '(' << found << ")\n";
+    }
+}
+
+// one addElements call against an insert per element, for sorted input
+void bench_add(std::size_t n) {
+    std::vector<long> input(n);
+    for (std::size_t i = 0; i < n; ++i)
+        input[i] = static_cast<long>(3 * i);
+    const auto time_ms = [](auto&& f) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    const auto compare = [&](const char* name, auto container, auto&& one_by_one) {
+        auto copy = container;
+        const double single = time_ms([&] {
+            for (const auto v : input)
+                one_by_one(copy, v);
+        });
+        const double bulk = time_ms([&] { addElements(container, input); });
+        std::cout << name << ":\t" << single << " ms one by one, " << bulk << " ms with addElements"
+                  << (container == copy ? "" : " (MISMATCH)") << '\n';
+    };
+    std::cout << n << " sorted elements\n";
+    compare("vector   ", std::vector<long>{}, [](auto& c, long v) { c.push_back(v); });
+    compare("set      ", std::set<long>{}, [](auto& c, long v) { c.insert(v); });
+    compare("flat_set ", flat_set<long>{}, [](auto& c, long v) { c.insert(v); });
+    compare("swiss_set", swiss_set<long>{}, [](auto& c, long v) { c.insert(v); });
+}
+
+// a constant table of 256 integer keys, looked up 10^7 times through each container
+void bench_frozen() {
+    static constexpr auto entries = [] {
+        std::array<std::pair<int, int>, 256> e{};
+        for (int i = 0; i < 256; ++i)
+            e[static_cast<std::size_t>(i)] = {i * i * 7 + 3, i};
+        return e;
+    }();
+    static constexpr frozen_map<int, int, 256> frozen{entries};
+    const flat_map<int, int> flat(entries.begin(), entries.end());
+    swiss_map<int, int> swiss;
+    swiss.insert(entries.begin(), entries.end());
+    const std::unordered_map<int, int> unordered(entries.begin(), entries.end());
+
+    std::mt19937 rng{3};
+    std::vector<int> queries(10'000'000);
+    for (auto& q : queries)
+        q = entries[rng() % 256].first + static_cast<int>(rng() % 4 == 0);  // a quarter miss
+    const auto run = [&](const char* name, const auto& table) {
+        long sum{0};
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto q : queries)
+            if (const auto it = table.find(q); it != table.end())
+                sum += it->second;
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << name << elapsed.count() / static_cast<double>(queries.size()) << " ns/find (" << sum << ")\n";
+    };
+    run("frozen_map:         ", frozen);
+    run("flat_map:           ", flat);
+    run("swiss_map:          ", swiss);
+    run("std::unordered_map: ", unordered);
+}
+
+int main(int argc, char* argv[]) {
     std::vector<int> v{};
     std::set<int> s{};
+    flat_set<int> fs{};
+    flat_map<int, char> fm{};
+    swiss_set<int> ss{};
+    swiss_map<int, char> sm{};
 
     for (int i = 0; i < 10; ++i) {
         addElement(v, i);
         addElement(s, i);
+        addElement(fs, 9 - i);
+        addElement(fm, std::pair{i % 5, static_cast<char>('a' + i)});
+        addElement(ss, i * i);
+        addElement(sm, std::pair{i, static_cast<char>('a' + i)});
     }
 
     print(v);
     print(s);
+    print(fs);
+    print(fm);
+    print(ss);
+    print(sm);
+
+    addElements(v, std::views::iota(10, 15));
+    addElements(s, std::vector{12, 11, 10});
+    addElements(fs, std::views::iota(10, 15));
+    addElements(ss, std::views::iota(100, 103));
+    print(v);
+    print(s);
+    print(fs);
+    print(ss);
+
+    static constexpr auto weekdays = make_frozen_map<std::string_view, int>(
+        {{"mon", 1}, {"tue", 2}, {"wed", 3}, {"thu", 4}, {"fri", 5}, {"sat", 6}, {"sun", 7}});
+    static_assert(weekdays.at("wed") == 3 && !weekdays.contains("xyz"));
+    for (const std::string_view day : {"sat", "fri", "xmas"})
+        std::cout << day << " -> " << (weekdays.contains(day) ? weekdays.at(day) : 0) << '\n';
+
+    // run with "bench" for lookups from 10 to 10^7 keys, "bench N" to stop at N keys
+    if (argc > 1 && std::string_view{argv[1]} == "bench") {
+        const std::size_t max_keys = argc > 2 ? std::stoul(argv[2]) : 10'000'000;
+        bench_lookup(max_keys);
+        bench_hash(max_keys);
+        bench_add(std::min<std::size_t>(max_keys, 1'000'000));
+        bench_frozen();
+    }
 
     return EXIT_SUCCESS;
 }
 
-// compile with g++ --std=c++20 -o exec AssociativeContainer.cpp
+// compile with g++ --std=c++20 -O2 -o exec AssociativeContainer.cpp
+// add -DADD_ELEMENTS_TRACE=1 to see which addElements overload is taken
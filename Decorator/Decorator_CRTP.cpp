@@ -1,14 +1,15 @@
-
+#include <charconv>
 #include <concepts>
 #include <cstdint>
+#include <numeric>
 #include <ostream>
+#include <stdexcept>
 #include <type_traits>
 // Have a look at the curiously recurring template pattern (CRTP): https://en.wikipedia.org/wiki/Curiously_recurring_template_pattern
 // And note, that this was discovered by accident, this is not a specialized compiler feature :D
 
-template <typename T>
-concept arithmetic = std::is_arithmetic_v<T>;
-
+// Money is an exact number of cents. Arithmetic on it stays in integers: scaling goes through a
+// Rate with a 128-bit intermediate and an explicit rounding mode, and printing formats the cents.
 class Money {
 public:
     Money() = default;
@@ -17,25 +18,20 @@ public:
     constexpr explicit Money(T v)
         : value_{static_cast<std::int64_t>(v)} {}
 
-    template <std::floating_point T>  // C++20 concept
-    constexpr explicit Money(T v)
-        : value_{static_cast<std::int64_t>(v * 100.0)} {}
-
-    constexpr float as_float() const { return value_ * 0.01F; }
     constexpr std::int64_t as_int64_t() const { return value_; }
 
 private:
     std::int64_t value_{};
 };
 
-template <arithmetic T>  // C++20 concept
+template <std::integral T>  // C++20 concept
 constexpr Money operator*(Money money, T factor) {
-    return Money{static_cast<std::int64_t>(money.as_int64_t() * factor)};
+    return Money{money.as_int64_t() * static_cast<std::int64_t>(factor)};
 }
 
-template <arithmetic T>  // C++20 concept
+template <std::integral T>  // C++20 concept
 constexpr Money operator*(T factor, Money money) {
-    return Money{static_cast<std::int64_t>(factor * money.as_int64_t())};
+    return money * factor;
 }
 
 constexpr Money operator+(Money lhs, Money rhs) {
@@ -58,12 +54,115 @@ constexpr bool operator<(Money lhs, Money rhs) {
     return lhs.as_int64_t() < rhs.as_int64_t();
 }
 
+// writes e.g. "-1234.05", at most 21 characters
+inline std::to_chars_result to_chars(char* first, char* last, Money money) {
+    const std::int64_t cents = money.as_int64_t();
+    const std::uint64_t magnitude = cents < 0 ? 0 - static_cast<std::uint64_t>(cents) : static_cast<std::uint64_t>(cents);
+    if (cents < 0) {
+        if (first == last)
+            return {last, std::errc::value_too_large};
+        *first++ = '-';
+    }
+    const auto [end, error] = std::to_chars(first, last, magnitude / 100);
+    if (error != std::errc{})
+        return {end, error};
+    if (last - end < 3)
+        return {last, std::errc::value_too_large};
+    end[0] = '.';
+    end[1] = static_cast<char>('0' + magnitude % 100 / 10);
+    end[2] = static_cast<char>('0' + magnitude % 10);
+    return {end + 3, std::errc{}};
+}
+
+// for output only, e.g. to plot prices; computing with the result gives up exactness
+constexpr double to_double(Money money) {
+    return static_cast<double>(money.as_int64_t()) / 100.0;
+}
+
 std::ostream& operator<<(std::ostream& os, Money money) {
-    return os << money.as_float();
+    char buffer[24];
+    return os.write(buffer, to_chars(buffer, buffer + sizeof(buffer), money).ptr - buffer);
+}
+
+// ---- Rate.h ----
+// An exact factor num / den, kept in lowest terms, e.g. Rate::basis_points(11'900) for 1.19. Scaling
+// Money by it multiplies into 128 bits, divides, and rounds the remainder as asked; a result that
+// does not fit into Money throws.
+enum class Rounding {
+    toward_zero,
+    half_up,    // half away from zero, commercial rounding
+    half_even,  // banker's rounding
+    down,       // toward negative infinity
+    up,         // toward positive infinity
+};
+
+class Rate {
+public:
+    constexpr Rate() = default;
+    constexpr Rate(std::int64_t num, std::int64_t den) {
+        if (den <= 0)
+            throw std::invalid_argument("Rate: the denominator must be positive");
+        const std::int64_t divisor = std::gcd(num, den);
+        num_ = num / divisor;
+        den_ = den / divisor;
+    }
+
+    static constexpr Rate basis_points(std::int64_t bp) { return Rate{bp, 10'000}; }
+
+    constexpr std::int64_t num() const { return num_; }
+    constexpr std::int64_t den() const { return den_; }
+
+    // 1 + this, for turning a tax into the factor that applies it
+    constexpr Rate plus_one() const { return Rate{num_ + den_, den_}; }
+
+private:
+    std::int64_t num_{1};
+    std::int64_t den_{1};
+};
+
+namespace detail {
+constexpr std::uint64_t magnitude(std::int64_t v) {
+    return v < 0 ? 0 - static_cast<std::uint64_t>(v) : static_cast<std::uint64_t>(v);
+}
+
+// whether the quotient's magnitude goes up by one, given the remainder left by the division
+constexpr bool rounds_away(Rounding rounding, std::uint64_t remainder, std::uint64_t den, bool odd, bool negative) {
+    switch (rounding) {
+    case Rounding::toward_zero: return false;
+    case Rounding::half_up: return remainder >= den - remainder;
+    case Rounding::half_even: return remainder > den - remainder || (remainder == den - remainder && odd);
+    case Rounding::down: return negative && remainder != 0;
+    case Rounding::up: return !negative && remainder != 0;
+    }
+    return false;
+}
+}  // namespace detail
+
+constexpr Money scale(Money money, Rate rate, Rounding rounding) {
+    const bool negative = (money.as_int64_t() < 0) != (rate.num() < 0);
+    const unsigned __int128 product =
+        static_cast<unsigned __int128>(detail::magnitude(money.as_int64_t())) * detail::magnitude(rate.num());
+    const auto den = static_cast<std::uint64_t>(rate.den());
+    // a 128-bit division is a library call, most products fit into 64 bits
+    const bool narrow = (product >> 64) == 0;
+    unsigned __int128 quotient = narrow ? static_cast<std::uint64_t>(product) / den : product / den;
+    const auto remainder = narrow ? static_cast<std::uint64_t>(product) % den : static_cast<std::uint64_t>(product % den);
+    quotient += detail::rounds_away(rounding, remainder, den, quotient & 1, negative);
+    if (quotient > (negative ? detail::magnitude(INT64_MIN) : static_cast<std::uint64_t>(INT64_MAX)))
+        throw std::overflow_error("scale: the result does not fit into Money");
+    const auto cents = static_cast<std::uint64_t>(quotient);
+    return Money{static_cast<std::int64_t>(negative ? 0 - cents : cents)};
+}
+
+constexpr Money operator*(Money money, Rate rate) {
+    return scale(money, rate, Rounding::half_up);
 }
 
 // ---- Item.h ------
 // #include <Money>
+// price() is computed on every call and never cached. The layers are nested by value, so a cache
+// would have to ask every layer below whether it changed, which costs as much as the adds and the
+// scale it saves. Without a cache, price() writes nothing, and threads can share a stack.
 template<typename Derived>
 class Item {
 protected:
@@ -89,6 +188,15 @@ public:
     const std::string& name() const { return name_; }
     Money price() const { return price_; }
 
+    void set_price(Money price) {
+        price_ = price;
+    }
+
+    // the base price is not an op, in batch pricing it comes from the price column
+    static constexpr std::size_t depth{0};
+    template <typename Op>
+    constexpr void collect_ops(Op*&) const {}
+
 private:
     std::string name_;
     Money price_;
@@ -104,11 +212,23 @@ public:
     template<typename... Args>
     Milk(Args&&... args)
         : item_(std::forward<Args>(args)...),
-          milk_surcharge_{0.2} {
+          milk_surcharge_{20} {
     }
 
     Money price() const { return item_.price() + milk_surcharge_; }
 
+    void set_surcharge(Money surcharge) { milk_surcharge_ = surcharge; }
+
+    TItem& item() { return item_; }
+    const TItem& item() const { return item_; }
+
+    static constexpr std::size_t depth{TItem::depth + 1};
+    template <typename Op>
+    constexpr void collect_ops(Op*& out) const {
+        item_.collect_ops(out);
+        *out++ = Op::add(milk_surcharge_);
+    }
+
 private:
     TItem item_;
     Money milk_surcharge_;
@@ -116,26 +236,289 @@ private:
 
 // ---- Tax.h ----
 // #include <DecoratedItem>
+// The tax is an exact Rate, like Rate{19, 100}, never a floating-point number.
 #include <memory>
 #include <stdexcept>
 template <typename TItem>
     class Tax : public Item <Tax<TItem>> {
 public:
     template <typename... Args>
-    Tax(double factor, Args&&... args)
+    Tax(Rate tax, Args&&... args)
         : item_(std::forward<Args>(args)...),
-          factor_{1. + factor} {
+          factor_{tax.plus_one()} {
     }
 
-    Money price() const { return item_.price() * factor_; }
+    Money price() const { return scale(item_.price(), factor_, rounding_); }
+
+    void set_tax(Rate tax) { factor_ = tax.plus_one(); }
+    void set_rounding(Rounding rounding) { rounding_ = rounding; }
+
+    TItem& item() { return item_; }
+    const TItem& item() const { return item_; }
+
+    static constexpr std::size_t depth{TItem::depth + 1};
+    template <typename Op>
+    constexpr void collect_ops(Op*& out) const {
+        item_.collect_ops(out);
+        *out++ = Op::scale(factor_, rounding_);
+    }
 
 private:
     TItem item_;
-    double factor_;
+    Rate factor_;
+    Rounding rounding_{Rounding::half_up};
+};
+
+// ---- BatchPricing.h ----
+// Prices a whole column of base prices (in cents) through one decorator stack. The stack is
+// flattened into its ops, innermost first, and every op does exactly what price() does: an int64
+// addition, or scale() with the Tax's rate and rounding. The results are therefore identical to
+// price(). With AVX-512 IFMA eight prices go through the ops at once. For cents that are not
+// negative, rounding is an offset added before the division: a 52-bit multiply-add forms
+// cents * num + offset, and the division by den is a multiplication with a precomputed
+// reciprocal (Granlund and Montgomery). This is exact while that sum stays below 2^50. Ties to
+// even additionally check the remainder. A block of eight with a negative or too large lane is
+// redone by the scalar loop.
+// There is no AVX2 kernel, AVX2 lacks the 64-bit multiplies the exact division needs. Every CPU
+// without IFMA, which includes most client CPUs, and every build for another architecture or
+// compiler runs the scalar loop.
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define PRICING_X86_DISPATCH 1
+#endif
+
+struct PriceOp {
+    enum class Kind { add, scale };
+
+    static constexpr PriceOp add(Money surcharge) { return {Kind::add, surcharge}; }
+    static constexpr PriceOp scale(Rate factor, Rounding rounding) {
+        PriceOp op{Kind::scale, Money{}, factor, rounding};
+        const auto den = static_cast<std::uint64_t>(factor.den());
+        switch (rounding) {
+        case Rounding::toward_zero:
+        case Rounding::down: op.offset = 0; break;
+        case Rounding::half_up:
+        case Rounding::half_even: op.offset = den / 2; break;
+        case Rounding::up: op.offset = den - 1; break;
+        }
+        op.ties_to_even = rounding == Rounding::half_even && den % 2 == 0;
+        constexpr std::uint64_t bound{std::uint64_t{1} << 50};
+        if (factor.num() < 0 || den > bound)
+            op.limit = 0;
+        else if (factor.num() > 0)
+            op.limit = (bound - 1 - op.offset) / static_cast<std::uint64_t>(factor.num());
+        if (den > 1) {
+            op.shift = std::max(static_cast<std::int64_t>(std::bit_width(den - 1)), std::int64_t{2});
+            op.reciprocal = static_cast<std::uint64_t>((static_cast<unsigned __int128>(1) << (50 + op.shift)) / den + 1);
+            op.shift -= 2;
+        }
+        return op;
+    }
+
+    constexpr Money apply(Money money) const { return kind == Kind::add ? money + surcharge : ::scale(money, factor, rounding); }
+
+    Kind kind{Kind::add};
+    Money surcharge{};
+    Rate factor{};
+    Rounding rounding{Rounding::half_up};
+    // for the IFMA kernel: cents from 0 to limit scale to (cents * num + offset) / den, where
+    // x / den is (x * reciprocal) >> (52 + shift)
+    std::uint64_t limit{UINT64_MAX};
+    std::uint64_t offset{0};
+    std::uint64_t reciprocal{0};
+    std::int64_t shift{0};
+    bool ties_to_even{false};
 };
 
+template <typename TItem>
+constexpr std::array<PriceOp, TItem::depth> price_ops(const Item<TItem>& item) {
+    std::array<PriceOp, TItem::depth> ops{};
+    PriceOp* out = ops.data();
+    item.derived().collect_ops(out);
+    return ops;
+}
+
+namespace detail {
+// out of line, so that as the IFMA kernel's rare fallback it does not crowd the vector loop
+[[gnu::noinline]] inline void reprice_scalar(std::span<const PriceOp> ops, const std::int64_t* base, std::int64_t* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        Money money{base[i]};
+        for (const auto& op : ops)
+            money = op.apply(money);
+        out[i] = money.as_int64_t();
+    }
+}
+
+#ifdef PRICING_X86_DISPATCH
+// one op on eight cents, sets the lanes it could not scale exactly in `too_large`
+__attribute__((target("avx512f,avx512ifma"), always_inline)) inline __m512i apply_ifma(const PriceOp& op, __m512i cents,
+                                                                                      __mmask8& too_large) {
+    if (op.kind == PriceOp::Kind::add)
+        return _mm512_add_epi64(cents, _mm512_set1_epi64(op.surcharge.as_int64_t()));
+    // negative cents are huge as unsigned, so they fail the limit too
+    too_large |= _mm512_cmpgt_epu64_mask(cents, _mm512_set1_epi64(static_cast<std::int64_t>(op.limit)));
+    const __m512i sum = _mm512_madd52lo_epu64(_mm512_set1_epi64(static_cast<std::int64_t>(op.offset)), cents,
+                                              _mm512_set1_epi64(op.factor.num()));
+    if (op.factor.den() == 1)
+        return sum;
+    const __m512i zero = _mm512_setzero_si512();
+    cents = _mm512_madd52hi_epu64(zero, sum, _mm512_set1_epi64(static_cast<std::int64_t>(op.reciprocal)));
+    cents = _mm512_maskz_srlv_epi64(0xFF, cents, _mm512_set1_epi64(op.shift));
+    if (op.ties_to_even) {
+        // a tie was rounded up, it goes back down if that made the quotient odd
+        const __m512i one = _mm512_set1_epi64(1);
+        const __mmask8 tie = _mm512_cmpeq_epi64_mask(sum, _mm512_madd52lo_epu64(zero, cents, _mm512_set1_epi64(op.factor.den())));
+        cents = _mm512_mask_sub_epi64(cents, _mm512_mask_test_epi64_mask(tie, cents, one), cents, one);
+    }
+    return cents;
+}
+
+// the number of ops is that of the stack, so the walk over them unrolls completely
+template <std::size_t N, std::size_t... I>
+__attribute__((target("avx512f,avx512ifma"), always_inline)) inline __m512i apply_ifma(const std::array<PriceOp, N>& ops, __m512i cents,
+                                                                                      __mmask8& too_large, std::index_sequence<I...>) {
+    ((cents = apply_ifma(ops[I], cents, too_large)), ...);
+    return cents;
+}
+
+template <std::size_t N>
+__attribute__((target("avx512f,avx512ifma"))) inline void reprice_ifma(const std::array<PriceOp, N>& ops, const std::int64_t* base,
+                                                                      std::int64_t* out, std::size_t n) {
+    constexpr auto all = std::make_index_sequence<N>{};
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __mmask8 too_large{0};
+        const __m512i cents = apply_ifma(ops, _mm512_loadu_si512(base + i), too_large, all);
+        if (too_large) [[unlikely]]
+            reprice_scalar(ops, base + i, out + i, 8);
+        else
+            _mm512_storeu_si512(out + i, cents);
+    }
+    if (i < n) {
+        const auto rest = static_cast<__mmask8>((1u << (n - i)) - 1);
+        __mmask8 too_large{0};
+        const __m512i cents = apply_ifma(ops, _mm512_maskz_loadu_epi64(rest, base + i), too_large, all);
+        if (too_large & rest)
+            reprice_scalar(ops, base + i, out + i, n - i);
+        else
+            _mm512_mask_storeu_epi64(out + i, rest, cents);
+    }
+}
+#endif
+}  // namespace detail
+
+// out[i] is the price of `stack` if its innermost item cost base_cents[i]
+template <typename TItem>
+void price_all(const Item<TItem>& stack, std::span<const std::int64_t> base_cents, std::span<std::int64_t> out) {
+    if (out.size() < base_cents.size())
+        throw std::invalid_argument("price_all: output column is too short");
+    const auto ops = price_ops(stack);
+#ifdef PRICING_X86_DISPATCH
+    if (__builtin_cpu_supports("avx512ifma"))
+        return detail::reprice_ifma(ops, base_cents.data(), out.data(), base_cents.size());
+#endif
+    detail::reprice_scalar(ops, base_cents.data(), out.data(), base_cents.size());
+}
+
+#include <chrono>
 #include <iostream>
-int main() {
-    Tax<Milk<Coffee>> espresso(0.19, "Espresso", Money{1.0});
+#include <random>
+#include <string_view>
+#include <vector>
+
+#ifdef PRICING_X86_DISPATCH
+// the former batch kernel, which scaled in double and truncated, as a baseline for the exact ones
+__attribute__((target("avx512f,avx512dq"))) void reprice_double_avx512(std::span<const PriceOp> ops, const std::int64_t* base,
+                                                                      std::int64_t* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; i += 8) {
+        const auto lanes = static_cast<__mmask8>(n - i >= 8 ? 0xFF : (1u << (n - i)) - 1);
+        __m512i cents = _mm512_maskz_loadu_epi64(lanes, base + i);
+        for (const auto& op : ops) {
+            if (op.kind == PriceOp::Kind::add)
+                cents = _mm512_add_epi64(cents, _mm512_set1_epi64(op.surcharge.as_int64_t()));
+            else
+                cents = _mm512_cvttpd_epi64(_mm512_mul_pd(_mm512_cvtepi64_pd(cents),
+                    _mm512_set1_pd(static_cast<double>(op.factor.num()) / static_cast<double>(op.factor.den()))));
+        }
+        _mm512_mask_storeu_epi64(out + i, lanes, cents);
+    }
+}
+#endif
+
+// scalar against batch repricing, `reps` times over a catalog of `count`, checked against price(),
+// with the former double batch kernel for comparison
+void bench_batch_pricing(std::size_t count, int reps) {
+    std::mt19937_64 rng{5};
+    std::vector<std::int64_t> base(count), scalar(count), batch(count), floating(count);
+    for (auto& cents : base)
+        cents = static_cast<std::int64_t>(rng() % 10'000'000);
+    const Tax<Milk<Coffee>> stack(Rate{19, 100}, "Espresso", Money{100});
+    const auto ops = price_ops(stack);
+
+    // the best of five rounds
+    const auto time_ms = [](auto&& f) {
+        double best{1e300};
+        for (int round = 0; round < 5; ++round) {
+            const auto start = std::chrono::steady_clock::now();
+            f();
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    };
+    const double scalar_ms = time_ms([&] {
+        for (int r = 0; r < reps; ++r)
+            detail::reprice_scalar(ops, base.data(), scalar.data(), count);
+    });
+    const double batch_ms = time_ms([&] {
+        for (int r = 0; r < reps; ++r)
+            price_all(stack, base, batch);
+    });
+    double double_ms{0.};
+#ifdef PRICING_X86_DISPATCH
+    if (__builtin_cpu_supports("avx512dq")) {
+        double_ms = time_ms([&] {
+            for (int r = 0; r < reps; ++r)
+                reprice_double_avx512(ops, base.data(), floating.data(), count);
+        });
+    }
+#endif
+
+    std::size_t mismatches{0};
+    for (std::size_t i = 0; i < count; ++i)
+        mismatches += scalar[i] != batch[i];
+    for (std::size_t i = 0; i < std::min<std::size_t>(count, 100'000); ++i)
+        mismatches += Tax<Milk<Coffee>>(Rate{19, 100}, "", Money{base[i]}).price().as_int64_t() != batch[i];
+    const double per_price = 1e6 / (static_cast<double>(count) * reps);
+    std::cout << count << " prices: scalar " << scalar_ms * per_price << " ns, batch " << batch_ms * per_price
+              << " ns, former double batch " << double_ms * per_price << " ns per price, " << mismatches << " mismatches\n";
+}
+
+int main(int argc, char* argv[]) {
+    Tax<Milk<Coffee>> espresso(Rate{19, 100}, "Espresso", Money{100});
     std::cout << "Espresso: " << espresso.price() << '\n';
+
+    const std::int64_t base[]{100, 250, 399, 1'000'000'001};
+    std::int64_t prices[std::size(base)];
+    price_all(espresso, base, prices);
+    for (std::size_t i = 0; i < std::size(base); ++i)
+        std::cout << "Espresso at " << Money{base[i]} << ": " << Money{prices[i]} << '\n';
+
+    espresso.item().item().set_price(Money{150});
+    std::cout << "Espresso with dearer beans: " << espresso.price();
+    espresso.set_tax(Rate{7, 100});
+    std::cout << ", at the reduced rate: " << espresso.price() << '\n';
+    espresso.item() = Milk<Coffee>("Doppio", Money{500});
+    std::cout << "Swapped for a doppio: " << espresso.price() << '\n';
+
+    // run with "bench" to reprice a catalog that fits into the cache, and ten million prices
+    if (argc > 1 && std::string_view{argv[1]} == "bench") {
+        bench_batch_pricing(8'192, 1'000);
+        bench_batch_pricing(10'000'000, 1);
+    }
 }
+
+// compile with g++ --std=c++20 -O2 -o decorator_crtp Decorator_CRTP.cpp
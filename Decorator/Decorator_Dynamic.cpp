@@ -61,14 +61,166 @@ std::ostream& operator<<(std::ostream& os, Money money) {
     return os << money.as_float();
 }
 
+// ---- PriceProgram.h ----
+// A decorator chain compiled into a flat list of ops on the base price, innermost first. Adjacent
+// surcharges are fused into one add. Scales stay separate, since price() truncates to cents after
+// each of them. A program of adds only has the closed form base + sum. Otherwise run() steps
+// through the ops in one tight loop, with no virtual calls and no pointer chasing.
+#include <span>
+#include <vector>
+
+class PriceProgram {
+public:
+    struct Op {
+        enum class Kind : std::uint8_t { add, scale };
+        Kind kind;
+        Money surcharge;
+        double factor;
+    };
+
+    void set_base(Money base) {
+        base_ = base;
+        ops_.clear();
+        surcharges_ = Money{};
+        only_adds_ = true;
+    }
+
+    void add(Money surcharge) {
+        if (!ops_.empty() && ops_.back().kind == Op::Kind::add)
+            ops_.back().surcharge = ops_.back().surcharge + surcharge;
+        else
+            ops_.push_back({Op::Kind::add, surcharge, 1.});
+        surcharges_ = surcharges_ + surcharge;
+    }
+
+    void scale(double factor) {
+        ops_.push_back({Op::Kind::scale, Money{}, factor});
+        only_adds_ = false;
+    }
+
+    Money run() const { return run(base_); }
+
+    // the price the chain would have if its innermost item cost `base`
+    Money run(Money base) const {
+        if (only_adds_)
+            return base + surcharges_;
+        for (const auto& op : ops_)
+            base = op.kind == Op::Kind::add ? base + op.surcharge : base * op.factor;
+        return base;
+    }
+
+    Money base() const { return base_; }
+    std::span<const Op> ops() const { return ops_; }
+
+private:
+    Money base_{};
+    std::vector<Op> ops_;
+    Money surcharges_{};
+    bool only_adds_{true};
+};
+
 // ---- Item.h ------
 
+// price() is memoized. Every item has a version, which a change to the item or to anything it
+// decorates bumps, from the changed item up through its parents. price() recomputes only when the
+// version moved since the last call, otherwise it is the cached value. The cache is atomic, so
+// threads may call price() on a shared chain: several may compute the same price, and a reader
+// that sees the current version also sees its price. Changes still need exclusive access.
+#include <atomic>
+#include <cstdint>
+
 class Item {
 public:
+    Item() = default;
+    // a copy is not part of the original's chain and starts with an empty cache
+    Item(const Item&) {}
+    Item& operator=(const Item&) {
+        invalidate();
+        return *this;
+    }
     virtual ~Item() = default;
-    virtual Money price() const = 0;
+
+    Money price() const {
+        if (cached_version_.load(std::memory_order_acquire) != version_) {
+            const Money price = compute_price();
+            cached_price_.store(price, std::memory_order_relaxed);
+            cached_version_.store(version_, std::memory_order_release);
+            return price;
+        }
+        return cached_price_.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t version() const { return version_; }
+
+    // appends this item to `program`. Items that do not know better are taken as a base of their
+    // current price().
+    virtual void compile(PriceProgram& program) const { program.set_base(price()); }
+
+protected:
+    virtual Money compute_price() const = 0;
+
+    // to be called after a change to anything compute_price() depends on
+    void invalidate() {
+        for (Item* item = this; item; item = item->parent_)
+            ++item->version_;
+    }
+
+private:
+    friend class DecoratedItem;
+
+    Item* parent_{nullptr};
+    std::uint64_t version_{1};
+    mutable std::atomic<std::uint64_t> cached_version_{0};
+    mutable std::atomic<Money> cached_price_{};
 };
 
+inline PriceProgram compile(const Item& item) {
+    PriceProgram program;
+    item.compile(program);
+    return program;
+}
+
+// ---- ItemPtr.h ----
+// Owning pointer to an Item that is either on the heap, from std::make_unique, or in a
+// std::pmr::memory_resource, from make_item. The deleter remembers which.
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+
+class ItemDeleter {
+public:
+    ItemDeleter() = default;
+    ItemDeleter(std::pmr::memory_resource* resource, std::size_t size, std::size_t alignment)
+        : resource_{resource}, size_{size}, alignment_{alignment} {}
+    // lets std::unique_ptr<Coffee> and friends convert to ItemPtr
+    template <std::derived_from<Item> T>
+    ItemDeleter(std::default_delete<T>) {}
+
+    void operator()(Item* item) const {
+        if (!resource_) {
+            delete item;
+            return;
+        }
+        item->~Item();
+        resource_->deallocate(item, size_, alignment_);
+    }
+
+private:
+    std::pmr::memory_resource* resource_{nullptr};
+    std::size_t size_{0};
+    std::size_t alignment_{0};
+};
+
+using ItemPtr = std::unique_ptr<Item, ItemDeleter>;
+
+template <std::derived_from<Item> T, typename... Args>
+ItemPtr make_item(std::pmr::memory_resource* resource, Args&&... args) {
+    std::pmr::polymorphic_allocator<> allocator{resource};
+    return ItemPtr{allocator.new_object<T>(std::forward<Args>(args)...),
+                   ItemDeleter{resource, sizeof(T), alignof(T)}};
+}
+
 // ---- Coffee.h -----
 // #include <Item>
 #include <string>
@@ -80,7 +232,15 @@ public:
         }
 
     const std::string& GetName() const { return name_; }
-    Money price() const override { return price_; }
+    void compile(PriceProgram& program) const override { program.set_base(price_); }
+
+    void set_price(Money price) {
+        price_ = price;
+        invalidate();
+    }
+
+protected:
+    Money compute_price() const override { return price_; }
 
 private:
     std::string name_;
@@ -93,11 +253,28 @@ private:
 #include <stdexcept>
 class DecoratedItem : public Item {
 public:
-    DecoratedItem(std::unique_ptr<Item>&& item)
+    DecoratedItem(ItemPtr&& item)
         : item_(std::move(item)) {
         if(!item_){
             throw std::invalid_argument("Invalid item");
         }
+        item_->parent_ = this;
+    }
+
+    // the wrapped item moves along and has to report its changes to the new owner
+    DecoratedItem(DecoratedItem&& other) noexcept
+        : Item(other), item_(std::move(other.item_)) {
+        if (item_)  // other may already have been moved from
+            item_->parent_ = this;
+    }
+    DecoratedItem& operator=(DecoratedItem&& other) noexcept {
+        if (this != &other) {
+            Item::operator=(other);
+            item_ = std::move(other.item_);
+            if (item_)
+                item_->parent_ = this;
+        }
+        return *this;
     }
 
 protected:
@@ -105,7 +282,7 @@ protected:
     const Item& item() const { return *item_; }
 
 private:
-    std::unique_ptr<Item> item_;
+    ItemPtr item_;
 };
 
 // ---- Milk.h ----
@@ -114,11 +291,22 @@ private:
 #include <stdexcept>
 class Milk : public DecoratedItem {
 public:
-    Milk(std::unique_ptr<Item>&& item)
+    Milk(ItemPtr&& item)
         : DecoratedItem(std::move(item)), milk_surcharge_{0.2} {
     }
 
-    Money price() const override {
+    void compile(PriceProgram& program) const override {
+        item().compile(program);
+        program.add(milk_surcharge_);
+    }
+
+    void set_surcharge(Money surcharge) {
+        milk_surcharge_ = surcharge;
+        invalidate();
+    }
+
+protected:
+    Money compute_price() const override {
         return item().price() + milk_surcharge_;
     }
 
@@ -132,11 +320,22 @@ private:
 #include <stdexcept>
 class Tax : public DecoratedItem {
 public:
-    Tax(double factor, std::unique_ptr<Item>&& item)
+    Tax(double factor, ItemPtr&& item)
         : DecoratedItem(std::move(item)), factor_{1. + factor} {
     }
 
-    Money price() const override {
+    void compile(PriceProgram& program) const override {
+        item().compile(program);
+        program.scale(factor_);
+    }
+
+    void set_tax(double factor) {
+        factor_ = 1. + factor;
+        invalidate();
+    }
+
+protected:
+    Money compute_price() const override {
         return item().price() * factor_;
     }
 
@@ -144,12 +343,209 @@ private:
     double factor_;
 };
 
+// ---- Order.h ----
+// One order and its decorator chain. All layers come from the order's monotonic arena, whose
+// first bytes live inside the Order itself: building a chain of a few layers does not touch the
+// global heap, and the order's memory goes away at once instead of layer by layer. clear() hands
+// the whole arena back in O(1), so one Order can be reused for order after order.
+class Order {
+public:
+    Order() = default;
+    Order(const Order&) = delete;
+    Order& operator=(const Order&) = delete;
+
+    std::pmr::memory_resource* resource() { return &arena_; }
+
+    template <std::derived_from<Item> T, typename... Args>
+    ItemPtr make(Args&&... args) {
+        return make_item<T>(&arena_, std::forward<Args>(args)...);
+    }
+
+    void set_item(ItemPtr item) { item_ = std::move(item); }
+
+    void clear() {
+        item_.reset();
+        arena_.release();
+    }
+
+    const Item& item() const { return *item_; }
+    Money price() const { return item_->price(); }
+
+private:
+    alignas(std::max_align_t) std::byte buffer_[256];
+    std::pmr::monotonic_buffer_resource arena_{buffer_, sizeof(buffer_)};
+    ItemPtr item_;  // declared last, so the chain is destroyed before its arena
+};
+
+#include <chrono>
 #include <iostream>
-int
-main() {
+#include <random>
+#include <string_view>
+
+// random chains of Milk and Tax, priced through the chain and through their compiled programs
+void bench_compiled(std::size_t count) {
+    std::mt19937_64 rng{9};
+    std::vector<std::unique_ptr<Item>> items;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::unique_ptr<Item> item = std::make_unique<Coffee>("Coffee", Money{static_cast<std::int64_t>(rng() % 1000)});
+        for (std::size_t layer = 0, layers = 1 + rng() % 5; layer < layers; ++layer) {
+            if (rng() % 2 == 0)
+                item = std::make_unique<Milk>(std::move(item));
+            else
+                item = std::make_unique<Tax>(0.07 + 0.12 * static_cast<double>(rng() % 2), std::move(item));
+        }
+        items.push_back(std::move(item));
+    }
+
+    const auto time_ms = [](auto&& f) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    std::vector<PriceProgram> programs;
+    programs.reserve(count);
+    const double compile_ms = time_ms([&] {
+        for (const auto& item : items)
+            programs.push_back(compile(*item));
+    });
+    std::vector<Money> chained(count), compiled(count);
+    const double chain_ms = time_ms([&] {
+        for (std::size_t i = 0; i < count; ++i)
+            chained[i] = items[i]->price();
+    });
+    const double program_ms = time_ms([&] {
+        for (std::size_t i = 0; i < count; ++i)
+            compiled[i] = programs[i].run();
+    });
+    std::cout << count << " chains: price() " << chain_ms << " ms, compiled run() " << program_ms
+              << " ms (compiling " << compile_ms << " ms), "
+              << (chained == compiled ? "identical" : "MISMATCH") << '\n';
+}
+
+// `threads` threads each build, price and drop `orders` orders, through make_unique or an arena
+#include <thread>
+void bench_arena(unsigned threads, std::size_t orders) {
+    const auto run = [&](auto&& build_and_price) {
+        std::vector<std::int64_t> sums(threads);
+        const auto start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> workers;
+            for (unsigned t = 0; t < threads; ++t)
+                workers.emplace_back([&, t] {
+                    for (std::size_t i = 0; i < orders; ++i)
+                        sums[t] += build_and_price(static_cast<std::int64_t>(i % 500)).as_int64_t();
+                });
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(threads * orders) / elapsed.count() / 1e6;
+    };
+    const double heap = run([](std::int64_t cents) {
+        const auto drink = std::make_unique<Tax>(0.19, std::make_unique<Milk>(std::make_unique<Coffee>("Espresso", Money{cents})));
+        return drink->price();
+    });
+    const double arena = run([](std::int64_t cents) {
+        Order order;
+        order.set_item(order.make<Tax>(0.19, order.make<Milk>(order.make<Coffee>("Espresso", Money{cents}))));
+        return order.price();
+    });
+    const double reused = run([](std::int64_t cents) {
+        thread_local Order order;
+        order.clear();
+        order.set_item(order.make<Tax>(0.19, order.make<Milk>(order.make<Coffee>("Espresso", Money{cents}))));
+        return order.price();
+    });
+    std::cout << threads << " thread(s): make_unique " << heap << ", arena " << arena
+              << ", reused arena " << reused << " Morders/s\n";
+}
+
+// `count` chains read `reads` times each, with the beans of every chain repriced in between, and
+// checked against freshly built chains
+void bench_memoized(std::size_t count, int reads) {
+    std::vector<std::unique_ptr<Item>> items;
+    std::vector<Coffee*> beans;
+    for (std::size_t i = 0; i < count; ++i) {
+        auto coffee = std::make_unique<Coffee>("Coffee", Money{static_cast<std::int64_t>(i % 1000)});
+        beans.push_back(coffee.get());
+        items.push_back(std::make_unique<Tax>(0.19,
+            std::make_unique<Milk>(std::make_unique<Milk>(std::make_unique<Tax>(0.07, std::move(coffee))))));
+    }
+
+    const auto time_ns = [count](auto&& f) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(count);
+    };
+    std::int64_t sum{0};
+    const double first_ns = time_ns([&] {
+        for (const auto& item : items)
+            sum += item->price().as_int64_t();
+    });
+    const double cached_ns = time_ns([&] {
+        for (int r = 0; r < reads; ++r)
+            for (const auto& item : items)
+                sum += item->price().as_int64_t();
+    }) / reads;
+    for (std::size_t i = 0; i < count; ++i)
+        beans[i]->set_price(Money{static_cast<std::int64_t>(i % 1000 + 1)});
+    const double changed_ns = time_ns([&] {
+        for (const auto& item : items)
+            sum += item->price().as_int64_t();
+    });
+
+    std::size_t mismatches{0};
+    for (std::size_t i = 0; i < count; ++i) {
+        const Tax fresh(0.19, std::make_unique<Milk>(std::make_unique<Milk>(
+            std::make_unique<Tax>(0.07, std::make_unique<Coffee>("Coffee", Money{static_cast<std::int64_t>(i % 1000 + 1)})))));
+        mismatches += items[i]->price() != fresh.price();
+    }
+    std::cout << count << " chains of 5: first price() " << first_ns << " ns, cached " << cached_ns
+              << " ns, after a change " << changed_ns << " ns, " << mismatches << " mismatches (" << sum % 10 << ")\n";
+}
+
+int main(int argc, char* argv[]) {
     std::unique_ptr<Item> espresso(
         std::make_unique<Tax>(0.19,
             std::make_unique<Milk>(
-                std::make_unique<Coffee>("Espresso", Money{1.}))));
+                std::make_unique<Milk>(
+                    std::make_unique<Coffee>("Espresso", Money{1.})))));
     std::cout << "Espresso: " << espresso->price() << '\n';
-}
\ No newline at end of file
+
+    const PriceProgram program = compile(*espresso);
+    std::cout << "compiled to " << program.ops().size() << " ops: " << program.run()
+              << ", at a base of 2: " << program.run(Money{2.}) << '\n';
+
+    Order order;
+    order.set_item(order.make<Tax>(0.19,
+        order.make<Milk>(order.make<Milk>(order.make<Coffee>("Espresso", Money{1.})))));
+    std::cout << "Espresso from the arena: " << order.price() << '\n';
+
+    auto beans = std::make_unique<Coffee>("Latte", Money{2.});
+    Coffee& latte_beans = *beans;
+    auto milk = std::make_unique<Milk>(std::move(beans));
+    Milk& latte_milk = *milk;
+    const Tax latte(0.19, std::move(milk));
+    std::cout << "Latte: " << latte.price();
+    latte_beans.set_price(Money{3.});
+    std::cout << ", with dearer beans: " << latte.price();
+    latte_milk.set_surcharge(Money{0.5});
+    std::cout << ", and oat milk: " << latte.price() << " (version " << latte.version() << ")\n";
+
+    auto flat_white_beans = std::make_unique<Coffee>("Flat white", Money{2.});
+    Coffee& flat_white_beans_ref = *flat_white_beans;
+    Milk poured(std::move(flat_white_beans));
+    const Milk flat_white(std::move(poured));
+    std::cout << "Flat white: " << flat_white.price();
+    flat_white_beans_ref.set_price(Money{3.});
+    std::cout << ", after a move and with dearer beans: " << flat_white.price() << '\n';
+
+    // run with "bench" to compare the chains with their compiled programs, memoized with computed
+    // prices, and heap allocated with arena allocated chains on 1, 2, 4 and 8 threads
+    if (argc > 1 && std::string_view{argv[1]} == "bench") {
+        bench_compiled(1'000'000);
+        bench_memoized(1'000'000, 10);
+        for (unsigned threads = 1; threads <= 8; threads *= 2)
+            bench_arena(threads, 1'000'000);
+    }
+}
+
+// compile with g++ --std=c++20 -O2 -pthread -o decorator_dynamic Decorator_Dynamic.cpp
\ No newline at end of file
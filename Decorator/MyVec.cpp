@@ -1,8 +1,12 @@
 #include <concepts>
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <iostream>
+#include <memory>
 #include <type_traits>
 #include <cmath>
+#include <vector>
 
 template <typename T>
 concept VectorBaseContainer =
@@ -30,18 +34,114 @@ OS& operator<<(OS& os, const VectorData<T, N>& v) {
     return os;
 }
 
+// Storage padded to a full SIMD register (e.g. 3 doubles -> 4 doubles, 32 byte aligned), so kernels
+// can use aligned full-width loads. size() still reports N, the padding lanes are kept at zero.
+template <typename T, std::size_t N, std::size_t SimdBytes = 32>
+struct AlignedVectorData {
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static constexpr size_type lanes = std::max<size_type>(SimdBytes / sizeof(T), 1);
+    static constexpr size_type padded_size = N <= lanes ? std::bit_ceil(N) : (N + lanes - 1) / lanes * lanes;
+    static constexpr size_type alignment = std::min(padded_size * sizeof(T), SimdBytes);
+
+    constexpr size_type size() const noexcept { return N; }
+    constexpr T* data() noexcept { return elems_.data(); }
+    constexpr const T* data() const noexcept { return elems_.data(); }
+
+    constexpr T& operator[](size_type n) noexcept { return elems_[n]; }
+    constexpr const T& operator[](size_type n) const noexcept { return elems_[n]; }
+
+    constexpr iterator begin() noexcept { return data(); }
+    constexpr iterator end() noexcept { return data() + N; }
+    constexpr const_iterator begin() const noexcept { return data(); }
+    constexpr const_iterator end() const noexcept { return data() + N; }
+
+    // public to keep the type an aggregate, so the decorators can brace-initialize it like std::array
+    alignas(alignment) std::array<T, padded_size> elems_;
+};
+
+template<typename OS, typename T, std::size_t N, std::size_t SimdBytes>
+OS& operator<<(OS& os, const AlignedVectorData<T, N, SimdBytes>& v) {
+    if constexpr(N > 0) {
+        for (std::size_t n{0}; n < N - 1; n++)
+            os << v.data()[n] << ", ";
+        os << v.data()[N - 1];
+    }
+    return os;
+}
+
+// Non-owning view of N components in foreign memory (network frames, mmapped files, ...), with an
+// optional stride between the components. Like std::span, copying a view never copies the data.
+template <typename T, std::size_t N>
+class VectorView {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using owning_type = VectorData<std::remove_const_t<T>, N>;
+    static constexpr bool is_view = true;
+
+    constexpr VectorView() noexcept = default;
+    constexpr VectorView(T* first, size_type stride = 1) noexcept
+        : first_{first}, stride_{stride} {}
+
+    constexpr size_type size() const noexcept { return N; }
+    constexpr size_type stride() const noexcept { return stride_; }
+    constexpr T* data() noexcept { return first_; }
+    constexpr const T* data() const noexcept { return first_; }
+
+    constexpr T& operator[](size_type n) noexcept { return first_[n * stride_]; }
+    constexpr const T& operator[](size_type n) const noexcept { return first_[n * stride_]; }
+
+private:
+    T* first_{nullptr};
+    size_type stride_{1};
+};
+
+template <typename V>
+concept ViewVector = VectorBaseContainer<V> && V::is_view;
+
+template<typename OS, typename T, std::size_t N>
+OS& operator<<(OS& os, const VectorView<T, N>& v) {
+    if constexpr(N > 0) {
+        for (std::size_t n{0}; n < N - 1; n++)
+            os << v[n] << ", ";
+        os << v[N - 1];
+    }
+    return os;
+}
+
 // ---- VectorDecorators.h ----
+// Views over foreign memory set is_view and name the owning type that results are returned in.
+// Every decorator re-applies itself to that type via owning_type, so results keep their accessors.
+template <typename V>
+struct owning_vector {
+    using type = V;
+};
+
+template <typename V>
+    requires(V::is_view)
+struct owning_vector<V> {
+    using type = typename V::owning_type;
+};
+
+template <typename V>
+using owning_vector_t = typename owning_vector<V>::type;
+
 template <VectorBaseContainer Base>
     requires(Base{}.size() >= 1)
 class AccessX : public Base {
 public:
     using T = typename Base::value_type;
+    using owning_type = AccessX<owning_vector_t<Base>>;
     template <typename... Args>
     constexpr AccessX(Args&&... args)
         : Base{std::forward<Args>(args)...} {}
 
-    constexpr T& x() noexcept { return this->data()[0]; }
-    constexpr T x() const noexcept { return this->data()[0]; }
+    constexpr T& x() noexcept { return (*this)[0]; }
+    constexpr T x() const noexcept { return (*this)[0]; }
 };
 
 template <VectorBaseContainer Base>
@@ -49,12 +149,13 @@ template <VectorBaseContainer Base>
 class AccessY : public Base {
 public:
     using T = typename Base::value_type;
+    using owning_type = AccessY<owning_vector_t<Base>>;
     template <typename... Args>
     constexpr AccessY(Args&&... args)
         : Base{std::forward<Args>(args)...} {}
 
-    constexpr T& y() noexcept { return this->data()[1]; }
-    constexpr T y() const noexcept { return this->data()[1]; }
+    constexpr T& y() noexcept { return (*this)[1]; }
+    constexpr T y() const noexcept { return (*this)[1]; }
 };
 
 template <VectorBaseContainer Base>
@@ -62,12 +163,13 @@ template <VectorBaseContainer Base>
 class AccessZ : public Base {
 public:
     using T = typename Base::value_type;
+    using owning_type = AccessZ<owning_vector_t<Base>>;
     template <typename... Args>
     constexpr AccessZ(Args&&... args)
         : Base{std::forward<Args>(args)...} {}
 
-    constexpr T& z() noexcept { return this->data()[2]; }
-    constexpr T z() const noexcept { return this->data()[2]; }
+    constexpr T& z() noexcept { return (*this)[2]; }
+    constexpr T z() const noexcept { return (*this)[2]; }
 };
 
 template <VectorBaseContainer Base>
@@ -75,44 +177,82 @@ template <VectorBaseContainer Base>
 class AccessI : public Base {
 public:
     using T = typename Base::value_type;
+    using owning_type = AccessI<owning_vector_t<Base>>;
     template <typename... Args>
     constexpr AccessI(Args&&... args)
         : Base{std::forward<Args>(args)...} {}
 
-    constexpr T& i() noexcept { return this->data()[0]; }
-    constexpr T i() const noexcept { return this->data()[0]; }
+    constexpr T& i() noexcept { return (*this)[0]; }
+    constexpr T i() const noexcept { return (*this)[0]; }
 };
 
 template <VectorBaseContainer Base>
-    requires(Base{}.size() >= 1)
+    requires(Base{}.size() >= 2)
 class AccessJ : public Base {
 public:
     using T = typename Base::value_type;
+    using owning_type = AccessJ<owning_vector_t<Base>>;
     template <typename... Args>
     constexpr AccessJ(Args&&... args)
         : Base{std::forward<Args>(args)...} {}
 
-    constexpr T& j() noexcept { return this->data()[1]; }
-    constexpr T j() const noexcept { return this->data()[1]; }
+    constexpr T& j() noexcept { return (*this)[1]; }
+    constexpr T j() const noexcept { return (*this)[1]; }
 };
 
 template <VectorBaseContainer Base>
-    requires(Base{}.size() >= 2)
+    requires(Base{}.size() >= 3)
 class AccessK : public Base {
 public:
     using T = typename Base::value_type;
+    using owning_type = AccessK<owning_vector_t<Base>>;
     template <typename... Args>
     constexpr AccessK(Args&&... args)
         : Base{std::forward<Args>(args)...} {}
 
-    constexpr T& k() noexcept { return this->data()[0]; }
-    constexpr T k() const noexcept { return this->data()[0]; }
+    constexpr T& k() noexcept { return (*this)[2]; }
+    constexpr T k() const noexcept { return (*this)[2]; }
 };
 
+#ifndef MYVEC_RECURSIVE_ACCESSXYZ
+// One flat class per vector type, whatever N is: accessors which do not apply are removed by their
+// constraints instead of by one recursive specialization per dimension. This keeps the number of
+// instantiated classes (and forwarding constructors) at one, which matters for build times and
+// debug-info size in large code bases. The recursive variant is kept for comparison, see the end
+// of this file.
+template <VectorBaseContainer Base, std::size_t N = Base{}.size()>
+    requires(N <= Base{}.size())
+class AccessXYZ : public Base {
+public:
+    using T = typename Base::value_type;
+    using owning_type = AccessXYZ<owning_vector_t<Base>, N>;
+    template <typename... Args>
+    constexpr AccessXYZ(Args&&... args)
+        : Base{std::forward<Args>(args)...} {}
+
+    constexpr T& x() noexcept requires(N >= 1) { return (*this)[0]; }
+    constexpr T x() const noexcept requires(N >= 1) { return (*this)[0]; }
+
+    constexpr T& y() noexcept requires(N >= 2) { return (*this)[1]; }
+    constexpr T y() const noexcept requires(N >= 2) { return (*this)[1]; }
+
+    constexpr T& z() noexcept requires(N >= 3) { return (*this)[2]; }
+    constexpr T z() const noexcept requires(N >= 3) { return (*this)[2]; }
+
+    // any component by index, checked at compile time
+    template <std::size_t I>
+        requires(I < N)
+    constexpr T& get() noexcept { return (*this)[I]; }
+    template <std::size_t I>
+        requires(I < N)
+    constexpr T get() const noexcept { return (*this)[I]; }
+};
+#else
 template <VectorBaseContainer Base, std::size_t N = Base{}.size()>
 class AccessXYZ : public AccessXYZ<Base, N - 1> {
 public:
     using T = typename Base::value_type;
+    using owning_type = AccessXYZ<owning_vector_t<Base>, N>;
     template <typename... Args>
     constexpr AccessXYZ(Args&&... args)
         : AccessXYZ<Base, N - 1>{std::forward<Args>(args)...} {}
@@ -122,46 +262,51 @@ template <VectorBaseContainer Base>
 class AccessXYZ<Base, 3> : public AccessXYZ<Base, 2> {
 public:
     using T = typename Base::value_type;
+    using owning_type = AccessXYZ<owning_vector_t<Base>, 3>;
     template <typename... Args>
     constexpr AccessXYZ(Args&&... args)
         : AccessXYZ<Base, 2>{std::forward<Args>(args)...} {}
 
-    constexpr T& z() noexcept { return this->data()[2]; }
-    constexpr T z() const noexcept { return this->data()[2]; }
+    constexpr T& z() noexcept { return (*this)[2]; }
+    constexpr T z() const noexcept { return (*this)[2]; }
 };
 
 template <VectorBaseContainer Base>
 class AccessXYZ<Base, 2> : public AccessXYZ<Base, 1> {
 public:
     using T = typename Base::value_type;
+    using owning_type = AccessXYZ<owning_vector_t<Base>, 2>;
     template <typename... Args>
     constexpr AccessXYZ(Args&&... args)
         : AccessXYZ<Base, 1>{std::forward<Args>(args)...} {}
 
-    constexpr T& y() noexcept { return this->data()[1]; }
-    constexpr T y() const noexcept { return this->data()[1]; }
+    constexpr T& y() noexcept { return (*this)[1]; }
+    constexpr T y() const noexcept { return (*this)[1]; }
 };
 
 template <VectorBaseContainer Base>
 class AccessXYZ<Base, 1> : public AccessXYZ<Base, 0> {
 public:
     using T = typename Base::value_type;
+    using owning_type = AccessXYZ<owning_vector_t<Base>, 1>;
     template <typename... Args>
     constexpr AccessXYZ(Args&&... args)
         : AccessXYZ<Base, 0>{std::forward<Args>(args)...} {}
 
-    constexpr T& x() noexcept { return this->data()[0]; }
-    constexpr T x() const noexcept { return this->data()[0]; }
+    constexpr T& x() noexcept { return (*this)[0]; }
+    constexpr T x() const noexcept { return (*this)[0]; }
 };
 
 template <VectorBaseContainer Base>
 class AccessXYZ<Base, 0> : public Base {
 public:
     using T = typename Base::value_type;
+    using owning_type = AccessXYZ<owning_vector_t<Base>, 0>;
     template <typename... Args>
     constexpr AccessXYZ(Args&&... args)
         : Base{std::forward<Args>(args)...} {}
 };
+#endif
 
 namespace vfunc {
 template<VectorBaseContainer V>
@@ -171,26 +316,1137 @@ constexpr V dot(V v1, const V& v2) {
     return v1;
 }
 
+// a copy of a view would write the product into the viewed memory, so views return owning vectors
+template<ViewVector V>
+constexpr owning_vector_t<V> dot(V v1, const V& v2) {
+    owning_vector_t<V> result{};
+    for (std::size_t n{0}; n < v1.size(); n++)
+        result[n] = v1[n] * v2[n];
+    return result;
+}
+
 template <VectorBaseContainer V>
+constexpr std::remove_const_t<typename V::value_type> sum(const V& v) {
+    std::remove_const_t<typename V::value_type> s{0};
+    for (std::size_t n{0}; n < v.size(); n++)
+        s += v[n];
+    return s;
+}
+
+template<VectorBaseContainer V>
+constexpr std::remove_const_t<typename V::value_type> length(const V& v) {
+    std::remove_const_t<typename V::value_type> s{0};
+    for (std::size_t n{0}; n < v.size(); n++)
+        s += v[n] * v[n];
+    return std::sqrt(s);
+}
+}
+
+// ---- AlignedVectorKernels.h ----
+// Overloads of the vfunc kernels for padded storage. Element-wise work runs over the full padded
+// width with aligned loads, the padding lanes are masked to zero in the result and to -0.0 in
+// reductions (the identity of addition), so sums come out bit-identical to the unpadded kernels.
+// Unlike the batch kernels below, these pick AVX at compile time (-mavx or -march=native). Each
+// call handles a single vector and has to inline into its caller. A target("avx") function cannot
+// inline into code built without AVX, so a runtime switch would add a call and a branch to every
+// operation, which costs more than the operation itself. Without AVX the plain loops run.
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+template <typename V>
+concept PaddedVector = VectorBaseContainer<V> && requires {
+    { V::padded_size } -> std::convertible_to<std::size_t>;
+    { V::alignment } -> std::convertible_to<std::size_t>;
+} && (V::padded_size > V{}.size());
+
+namespace vfunc {
+namespace detail {
+#ifdef __AVX__
+template <std::size_t N>
+inline __m256d pad_mask() {
+    return _mm256_castsi256_pd(_mm256_setr_epi64x(N > 0 ? -1 : 0, N > 1 ? -1 : 0, N > 2 ? -1 : 0, N > 3 ? -1 : 0));
+}
+
+// (((0 + v0) + v1) + v2) + v3, the same order as the scalar loop
+inline double ordered_sum(__m256d v) {
+    const __m128d lo = _mm256_castpd256_pd128(v);
+    const __m128d hi = _mm256_extractf128_pd(v, 1);
+    __m128d s = _mm_add_sd(_mm_setzero_pd(), lo);
+    s = _mm_add_sd(s, _mm_unpackhi_pd(lo, lo));
+    s = _mm_add_sd(s, hi);
+    s = _mm_add_sd(s, _mm_unpackhi_pd(hi, hi));
+    return _mm_cvtsd_f64(s);
+}
+#endif
+
+template <PaddedVector V>
+constexpr bool is_avx_double4_v = std::same_as<typename V::value_type, double> && V::padded_size == 4 && V::alignment >= 32;
+}  // namespace detail
+
+template <PaddedVector V>
+constexpr V dot(V v1, const V& v2) {
+    constexpr std::size_t N{V{}.size()};
+#ifdef __AVX__
+    if constexpr (detail::is_avx_double4_v<V>) {
+        if (!std::is_constant_evaluated()) {
+            const __m256d p = _mm256_mul_pd(_mm256_load_pd(v1.data()), _mm256_load_pd(v2.data()));
+            _mm256_store_pd(v1.data(), _mm256_and_pd(p, detail::pad_mask<N>()));
+            return v1;
+        }
+    }
+#endif
+    typename V::value_type* a = v1.data();
+    const typename V::value_type* b = v2.data();
+    if (!std::is_constant_evaluated()) {
+        a = std::assume_aligned<V::alignment>(a);
+        b = std::assume_aligned<V::alignment>(b);
+    }
+    for (std::size_t n{0}; n < V::padded_size; n++)
+        a[n] = n < N ? a[n] * b[n] : typename V::value_type{0};
+    return v1;
+}
+
+template <PaddedVector V>
 constexpr typename V::value_type sum(const V& v) {
+#ifdef __AVX__
+    if constexpr (detail::is_avx_double4_v<V>) {
+        if (!std::is_constant_evaluated()) {
+            const __m256d x = _mm256_load_pd(v.data());
+            const __m256d m = detail::pad_mask<V{}.size()>();
+            return detail::ordered_sum(_mm256_or_pd(_mm256_and_pd(m, x), _mm256_andnot_pd(m, _mm256_set1_pd(-0.))));
+        }
+    }
+#endif
     typename V::value_type s{0};
-    for(const auto& e: v)
+    for (const auto& e : v)
         s += e;
     return s;
 }
 
-template<VectorBaseContainer V>
-constexpr typename V::value_type length(V v) {
-    v = vfunc::dot(v, v);
-    return std::sqrt(vfunc::sum(v));
+template <PaddedVector V>
+constexpr typename V::value_type length(const V& v) {
+#ifdef __AVX__
+    if constexpr (detail::is_avx_double4_v<V>) {
+        if (!std::is_constant_evaluated()) {
+            const __m256d x = _mm256_load_pd(v.data());
+            const __m256d m = detail::pad_mask<V{}.size()>();
+            const __m256d sq = _mm256_mul_pd(x, x);
+            return std::sqrt(detail::ordered_sum(_mm256_or_pd(_mm256_and_pd(m, sq), _mm256_andnot_pd(m, _mm256_set1_pd(-0.)))));
+        }
+    }
+#endif
+    typename V::value_type s{0};
+    for (const auto& e : v)
+        s += e * e;
+    return std::sqrt(s);
+}
+}  // namespace vfunc
+
+// ---- VectorBatch.h ----
+// Batched versions of the vfunc kernels, working on whole arrays of vectors at once.
+// For double 3-vectors the kernels are vectorized across vectors (one vector per SIMD lane),
+// the instruction set is picked at runtime. Every element is pushed through the same
+// sequence of operations regardless of its position in the array, so results are
+// bitwise-reproducible for a given ISA.
+#include <algorithm>
+#include <ranges>
+#include <stdexcept>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define VFUNC_X86_DISPATCH 1
+#endif
+
+namespace vfunc {
+
+enum class ISA { scalar, avx2, avx512 };
+
+inline ISA detect_isa() {
+#ifdef VFUNC_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return ISA::avx512;
+    if (__builtin_cpu_supports("avx2"))
+        return ISA::avx2;
+#endif
+    return ISA::scalar;
+}
+
+inline ISA active_isa() {
+    static const ISA isa{detect_isa()};
+    return isa;
+}
+
+// Storage types that hold their components in the object itself. Views hold a pointer instead,
+// which may be just as large. The decorators derive from their storage, so the lookup sees through them.
+namespace detail {
+template <typename T, std::size_t N>
+std::true_type inline_storage(const VectorData<T, N>*);
+template <typename T, std::size_t N, std::size_t SimdBytes>
+std::true_type inline_storage(const AlignedVectorData<T, N, SimdBytes>*);
+std::false_type inline_storage(const void*);
+}  // namespace detail
+
+template <typename V>
+inline constexpr bool is_inline_storage_v = decltype(detail::inline_storage(std::declval<const V*>()))::value;
+
+// a vector which consists of nothing but its components, so an array of them is a flat array of values
+template <typename V>
+concept PackedVector = VectorBaseContainer<V> && is_inline_storage_v<V> && std::is_standard_layout_v<V> &&
+                       sizeof(V) == V{}.size() * sizeof(typename V::value_type);
+
+static_assert(PackedVector<AccessXYZ<VectorData<double, 2>>>);
+static_assert(!PackedVector<AccessXYZ<VectorView<double, 2>>>, "a view is a pointer, even if as large as the values");
+
+template <typename R>
+concept VectorRange = std::ranges::contiguous_range<R> && PackedVector<std::ranges::range_value_t<R>>;
+
+namespace detail {
+// keep the compiler from fusing multiply and add into FMA, which would make the avx512
+// kernels round differently from the others
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+inline void mul_scalar(const double* a, const double* b, double* out, std::size_t n) {
+    for (std::size_t i{0}; i < n; i++)
+        out[i] = a[i] * b[i];
+}
+
+inline void sum3_scalar(const double* v, double* out, std::size_t n) {
+    for (std::size_t i{0}; i < n; i++)
+        out[i] = ((0. + v[3 * i]) + v[3 * i + 1]) + v[3 * i + 2];
+}
+
+inline void length3_scalar(const double* v, double* out, std::size_t n) {
+    for (std::size_t i{0}; i < n; i++) {
+        const double* p = v + 3 * i;
+        out[i] = std::sqrt((p[0] * p[0] + p[1] * p[1]) + p[2] * p[2]);
+    }
+}
+
+#ifdef VFUNC_X86_DISPATCH
+// Runs `kernel` over full blocks of W vectors and pushes the remainder through the same
+// kernel via a zero-padded stack buffer, so no element takes a different code path.
+// Every vector produces OutDim outputs.
+template <std::size_t W, std::size_t OutDim = 1, typename Kernel>
+inline void blocked3(const double* v, double* out, std::size_t n, Kernel kernel) {
+    std::size_t i{0};
+    for (; i + W <= n; i += W)
+        kernel(v + 3 * i, out + OutDim * i);
+    if (i < n) {
+        double in_tail[3 * W]{};
+        double out_tail[OutDim * W]{};
+        std::copy(v + 3 * i, v + 3 * n, in_tail);
+        kernel(in_tail, out_tail);
+        std::copy(out_tail, out_tail + OutDim * (n - i), out + OutDim * i);
+    }
+}
+
+// x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3  ->  x0 x1 x2 x3, y0 y1 y2 y3, z0 z1 z2 z3
+__attribute__((target("avx2"))) inline void load3_avx2(const double* p, __m256d& x, __m256d& y, __m256d& z) {
+    const __m256d m03 = _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(p + 0)), _mm_loadu_pd(p + 6), 1);
+    const __m256d m14 = _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(p + 2)), _mm_loadu_pd(p + 8), 1);
+    const __m256d m25 = _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(p + 4)), _mm_loadu_pd(p + 10), 1);
+    x = _mm256_shuffle_pd(m03, m14, 0b1010);
+    y = _mm256_shuffle_pd(m03, m25, 0b0101);
+    z = _mm256_shuffle_pd(m14, m25, 0b1010);
+}
+
+// inverse of load3_avx2
+__attribute__((target("avx2"))) inline void store3_avx2(double* p, __m256d x, __m256d y, __m256d z) {
+    const __m256d m03 = _mm256_unpacklo_pd(x, y);
+    const __m256d m14 = _mm256_shuffle_pd(z, x, 0b1010);
+    const __m256d m25 = _mm256_unpackhi_pd(y, z);
+    _mm_storeu_pd(p + 0, _mm256_castpd256_pd128(m03));
+    _mm_storeu_pd(p + 2, _mm256_castpd256_pd128(m14));
+    _mm_storeu_pd(p + 4, _mm256_castpd256_pd128(m25));
+    _mm_storeu_pd(p + 6, _mm256_extractf128_pd(m03, 1));
+    _mm_storeu_pd(p + 8, _mm256_extractf128_pd(m14, 1));
+    _mm_storeu_pd(p + 10, _mm256_extractf128_pd(m25, 1));
+}
+
+__attribute__((target("avx2"))) inline void mul_avx2(const double* a, const double* b, double* out, std::size_t n) {
+    std::size_t i{0};
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    mul_scalar(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx2"))) inline void sum3_avx2(const double* v, double* out, std::size_t n) {
+    blocked3<4>(v, out, n, [](const double* p, double* o) __attribute__((target("avx2"))) {
+        __m256d x, y, z;
+        load3_avx2(p, x, y, z);
+        const __m256d s = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_setzero_pd(), x), y), z);
+        _mm256_storeu_pd(o, s);
+    });
+}
+
+__attribute__((target("avx2"))) inline void length3_avx2(const double* v, double* out, std::size_t n) {
+    blocked3<4>(v, out, n, [](const double* p, double* o) __attribute__((target("avx2"))) {
+        __m256d x, y, z;
+        load3_avx2(p, x, y, z);
+        const __m256d s = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y)), _mm256_mul_pd(z, z));
+        _mm256_storeu_pd(o, _mm256_sqrt_pd(s));
+    });
+}
+
+// 8 vectors from three 512 bit loads, two cross-register permutes per component
+__attribute__((target("avx512f"))) inline void load3_avx512(const double* p, __m512d& x, __m512d& y, __m512d& z) {
+    const __m512d r0 = _mm512_loadu_pd(p);
+    const __m512d r1 = _mm512_loadu_pd(p + 8);
+    const __m512d r2 = _mm512_loadu_pd(p + 16);
+    x = _mm512_permutex2var_pd(_mm512_permutex2var_pd(r0, _mm512_setr_epi64(0, 3, 6, 9, 12, 15, 0, 0), r1),
+                               _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 10, 13), r2);
+    y = _mm512_permutex2var_pd(_mm512_permutex2var_pd(r0, _mm512_setr_epi64(1, 4, 7, 10, 13, 0, 0, 0), r1),
+                               _mm512_setr_epi64(0, 1, 2, 3, 4, 8, 11, 14), r2);
+    z = _mm512_permutex2var_pd(_mm512_permutex2var_pd(r0, _mm512_setr_epi64(2, 5, 8, 11, 14, 0, 0, 0), r1),
+                               _mm512_setr_epi64(0, 1, 2, 3, 4, 9, 12, 15), r2);
+}
+
+// inverse of load3_avx512
+__attribute__((target("avx512f"))) inline void store3_avx512(double* p, __m512d x, __m512d y, __m512d z) {
+    _mm512_storeu_pd(p, _mm512_permutex2var_pd(_mm512_permutex2var_pd(x, _mm512_setr_epi64(0, 8, 0, 1, 9, 0, 2, 10), y),
+                                               _mm512_setr_epi64(0, 1, 8, 3, 4, 9, 6, 7), z));
+    _mm512_storeu_pd(p + 8, _mm512_permutex2var_pd(_mm512_permutex2var_pd(x, _mm512_setr_epi64(0, 3, 11, 0, 4, 12, 0, 5), y),
+                                                   _mm512_setr_epi64(10, 1, 2, 11, 4, 5, 12, 7), z));
+    _mm512_storeu_pd(p + 16, _mm512_permutex2var_pd(_mm512_permutex2var_pd(x, _mm512_setr_epi64(13, 0, 6, 14, 0, 7, 15, 0), y),
+                                                    _mm512_setr_epi64(0, 13, 2, 3, 14, 5, 6, 15), z));
+}
+
+__attribute__((target("avx512f"))) inline void mul_avx512(const double* a, const double* b, double* out, std::size_t n) {
+    std::size_t i{0};
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_pd(out + i, _mm512_mul_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i)));
+    mul_scalar(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f"))) inline void sum3_avx512(const double* v, double* out, std::size_t n) {
+    blocked3<8>(v, out, n, [](const double* p, double* o) __attribute__((target("avx512f"))) {
+        __m512d x, y, z;
+        load3_avx512(p, x, y, z);
+        const __m512d s = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(_mm512_setzero_pd(), x), y), z);
+        _mm512_storeu_pd(o, s);
+    });
+}
+
+__attribute__((target("avx512f"))) inline void length3_avx512(const double* v, double* out, std::size_t n) {
+    blocked3<8>(v, out, n, [](const double* p, double* o) __attribute__((target("avx512f"))) {
+        __m512d x, y, z;
+        load3_avx512(p, x, y, z);
+        const __m512d s = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(x, x), _mm512_mul_pd(y, y)), _mm512_mul_pd(z, z));
+        _mm512_storeu_pd(o, _mm512_maskz_sqrt_pd(0xFF, s));
+    });
+}
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+// never run a kernel the CPU does not support, even if explicitly asked for
+inline ISA clamp(ISA isa) {
+    return static_cast<int>(isa) < static_cast<int>(active_isa()) ? isa : active_isa();
+}
+
+inline void mul(const double* a, const double* b, double* out, std::size_t n, ISA isa) {
+    switch (clamp(isa)) {
+#ifdef VFUNC_X86_DISPATCH
+        case ISA::avx512:
+            return mul_avx512(a, b, out, n);
+        case ISA::avx2:
+            return mul_avx2(a, b, out, n);
+#endif
+        default:
+            return mul_scalar(a, b, out, n);
+    }
+}
+
+inline void sum3(const double* v, double* out, std::size_t n, ISA isa) {
+    switch (clamp(isa)) {
+#ifdef VFUNC_X86_DISPATCH
+        case ISA::avx512:
+            return sum3_avx512(v, out, n);
+        case ISA::avx2:
+            return sum3_avx2(v, out, n);
+#endif
+        default:
+            return sum3_scalar(v, out, n);
+    }
+}
+
+inline void length3(const double* v, double* out, std::size_t n, ISA isa) {
+    switch (clamp(isa)) {
+#ifdef VFUNC_X86_DISPATCH
+        case ISA::avx512:
+            return length3_avx512(v, out, n);
+        case ISA::avx2:
+            return length3_avx2(v, out, n);
+#endif
+        default:
+            return length3_scalar(v, out, n);
+    }
+}
+
+template <typename V>
+constexpr bool is_double3_v = std::same_as<typename V::value_type, double> && V{}.size() == 3;
+
+template <typename... Sizes>
+void check_sizes(std::size_t n, Sizes... sizes) {
+    if (((sizes != n) || ...))
+        throw std::invalid_argument("Batch ranges differ in size");
+}
+}  // namespace detail
+
+// element-wise product of a[i] and b[i] for all i, written to out[i]
+template <VectorRange RA, VectorRange RB, VectorRange RO>
+    requires std::same_as<std::ranges::range_value_t<RA>, std::ranges::range_value_t<RB>> &&
+             std::same_as<std::ranges::range_value_t<RA>, std::ranges::range_value_t<RO>>
+void dot(const RA& a, const RB& b, RO&& out, ISA isa = active_isa()) {
+    using V = std::ranges::range_value_t<RA>;
+    const std::size_t n = std::ranges::size(a);
+    detail::check_sizes(n, std::ranges::size(b), std::ranges::size(out));
+    if (n == 0)  // the data() of an empty range may be null
+        return;
+    if constexpr (std::same_as<typename V::value_type, double>) {
+        detail::mul(std::ranges::data(a)->data(), std::ranges::data(b)->data(), std::ranges::data(out)->data(),
+                    n * V{}.size(), isa);
+    } else {
+        for (std::size_t i{0}; i < n; i++)
+            std::ranges::data(out)[i] = vfunc::dot(std::ranges::data(a)[i], std::ranges::data(b)[i]);
+    }
+}
+
+// sum of the components of every v[i], written to out[i]
+template <VectorRange R, std::ranges::contiguous_range RO>
+    requires std::same_as<std::ranges::range_value_t<RO>, typename std::ranges::range_value_t<R>::value_type>
+void sum(const R& v, RO&& out, ISA isa = active_isa()) {
+    using V = std::ranges::range_value_t<R>;
+    const std::size_t n = std::ranges::size(v);
+    detail::check_sizes(n, std::ranges::size(out));
+    if (n == 0)
+        return;
+    if constexpr (detail::is_double3_v<V>) {
+        detail::sum3(std::ranges::data(v)->data(), std::ranges::data(out), n, isa);
+    } else {
+        for (std::size_t i{0}; i < n; i++)
+            std::ranges::data(out)[i] = vfunc::sum(std::ranges::data(v)[i]);
+    }
+}
+
+// euclidean norm of every v[i], written to out[i]
+template <VectorRange R, std::ranges::contiguous_range RO>
+    requires std::same_as<std::ranges::range_value_t<RO>, typename std::ranges::range_value_t<R>::value_type>
+void length(const R& v, RO&& out, ISA isa = active_isa()) {
+    using V = std::ranges::range_value_t<R>;
+    const std::size_t n = std::ranges::size(v);
+    detail::check_sizes(n, std::ranges::size(out));
+    if (n == 0)
+        return;
+    if constexpr (detail::is_double3_v<V>) {
+        detail::length3(std::ranges::data(v)->data(), std::ranges::data(out), n, isa);
+    } else {
+        for (std::size_t i{0}; i < n; i++)
+            std::ranges::data(out)[i] = vfunc::length(std::ranges::data(v)[i]);
+    }
+}
+}  // namespace vfunc
+
+// ---- VectorBufferView.h ----
+// Zero-copy access to a raw buffer holding `count` vectors, e.g. a frame of particle positions.
+// The decorated view type V decides the accessors, the strides describe the layout in memory.
+template <ViewVector V>
+class VectorBufferView {
+public:
+    using value_type = typename V::value_type;
+    using size_type = std::size_t;
+    using reference = V;
+    static constexpr size_type dimension = V{}.size();
+
+    constexpr VectorBufferView(value_type* data, size_type count, size_type vector_stride = dimension,
+                               size_type component_stride = 1) noexcept
+        : data_{data}, count_{count}, vector_stride_{vector_stride}, component_stride_{component_stride} {}
+
+    constexpr size_type size() const noexcept { return count_; }
+    constexpr value_type* data() const noexcept { return data_; }
+
+    // densely packed like an array of VectorData, so the flat batch kernels apply
+    constexpr bool is_packed() const noexcept { return vector_stride_ == dimension && component_stride_ == 1; }
+
+    constexpr reference operator[](size_type i) const noexcept {
+        return reference{data_ + i * vector_stride_, component_stride_};
+    }
+
+private:
+    value_type* data_;
+    size_type count_;
+    size_type vector_stride_;
+    size_type component_stride_;
+};
+
+namespace vfunc {
+template <typename V, std::ranges::contiguous_range RO>
+    requires std::same_as<std::ranges::range_value_t<RO>, std::remove_const_t<typename V::value_type>>
+void sum(const VectorBufferView<V>& buffer, RO&& out, ISA isa = active_isa()) {
+    detail::check_sizes(buffer.size(), std::ranges::size(out));
+    if constexpr (detail::is_double3_v<owning_vector_t<V>>) {
+        if (buffer.is_packed())
+            return detail::sum3(buffer.data(), std::ranges::data(out), buffer.size(), isa);
+    }
+    for (std::size_t i{0}; i < buffer.size(); i++)
+        std::ranges::data(out)[i] = vfunc::sum(buffer[i]);
+}
+
+template <typename V, std::ranges::contiguous_range RO>
+    requires std::same_as<std::ranges::range_value_t<RO>, std::remove_const_t<typename V::value_type>>
+void length(const VectorBufferView<V>& buffer, RO&& out, ISA isa = active_isa()) {
+    detail::check_sizes(buffer.size(), std::ranges::size(out));
+    if constexpr (detail::is_double3_v<owning_vector_t<V>>) {
+        if (buffer.is_packed())
+            return detail::length3(buffer.data(), std::ranges::data(out), buffer.size(), isa);
+    }
+    for (std::size_t i{0}; i < buffer.size(); i++)
+        std::ranges::data(out)[i] = vfunc::length(buffer[i]);
+}
+}  // namespace vfunc
+
+// ---- VectorExpressions.h ----
+// Lazy arithmetic on decorated vectors: operators only build a light-weight expression tree,
+// which is evaluated component by component in a single loop by eval(), sum() or length().
+// Leaf vectors are referenced, not copied, so they need to outlive the expression.
+#include <functional>
+
+namespace vfunc {
+template <typename E>
+class VectorExpression {
+public:
+    constexpr const E& derived() const noexcept { return static_cast<const E&>(*this); }
+
+    static constexpr std::size_t size() noexcept { return E::extent; }
+
+    constexpr auto x() const noexcept requires(E::extent >= 1) { return derived()[0]; }
+    constexpr auto y() const noexcept requires(E::extent >= 2) { return derived()[1]; }
+    constexpr auto z() const noexcept requires(E::extent >= 3) { return derived()[2]; }
+
+    // materializes the expression in the decorated type of its leftmost vector
+    constexpr auto eval() const {
+        using R = typename E::result_type;
+        R result{};
+        for (std::size_t n{0}; n < E::extent; n++)
+            result.data()[n] = static_cast<typename R::value_type>(derived()[n]);
+        return result;
+    }
+};
+
+template <typename E>
+concept VectorExpr = std::derived_from<E, VectorExpression<E>>;
+
+template <VectorBaseContainer V>
+class VectorTerminal : public VectorExpression<VectorTerminal<V>> {
+public:
+    using value_type = typename V::value_type;
+    using result_type = owning_vector_t<V>;
+    static constexpr std::size_t extent = V{}.size();
+
+    constexpr explicit VectorTerminal(const V& v) noexcept
+        : v_{v} {}
+
+    constexpr value_type operator[](std::size_t n) const noexcept { return v_[n]; }
+
+private:
+    const V& v_;
+};
+
+template <VectorExpr L, VectorExpr R, typename Op>
+    requires(L::extent == R::extent)
+class VectorBinary : public VectorExpression<VectorBinary<L, R, Op>> {
+public:
+    using value_type = std::invoke_result_t<Op, typename L::value_type, typename R::value_type>;
+    using result_type = typename L::result_type;
+    static constexpr std::size_t extent = L::extent;
+
+    constexpr VectorBinary(L lhs, R rhs) noexcept
+        : lhs_{lhs}, rhs_{rhs} {}
+
+    constexpr value_type operator[](std::size_t n) const noexcept { return Op{}(lhs_[n], rhs_[n]); }
+
+private:
+    L lhs_;
+    R rhs_;
+};
+
+template <VectorExpr E, typename S>
+class VectorScaled : public VectorExpression<VectorScaled<E, S>> {
+public:
+    using value_type = std::common_type_t<typename E::value_type, S>;
+    using result_type = typename E::result_type;
+    static constexpr std::size_t extent = E::extent;
+
+    constexpr VectorScaled(E expr, S factor) noexcept
+        : expr_{expr}, factor_{factor} {}
+
+    constexpr value_type operator[](std::size_t n) const noexcept { return expr_[n] * factor_; }
+
+private:
+    E expr_;
+    S factor_;
+};
+
+template <typename T>
+concept VectorOperand = VectorBaseContainer<T> || VectorExpr<T>;
+
+// what the global arithmetic operators accept: expressions and decorated vectors, the types that
+// name an owning_type. Bare storage such as std::array keeps whatever operators others give it.
+template <typename T>
+concept ArithmeticOperand = VectorExpr<T> || (VectorBaseContainer<T> && requires { typename T::owning_type; });
+
+template <VectorOperand T>
+constexpr auto as_expression(const T& t) noexcept {
+    if constexpr (VectorExpr<T>)
+        return t;
+    else
+        return VectorTerminal<T>{t};
+}
+
+template <VectorOperand T>
+using expression_t = decltype(as_expression(std::declval<const T&>()));
+
+template <typename Op, VectorOperand L, VectorOperand R>
+constexpr auto make_binary(const L& lhs, const R& rhs) noexcept {
+    return VectorBinary<expression_t<L>, expression_t<R>, Op>{as_expression(lhs), as_expression(rhs)};
+}
+
+template <VectorExpr E>
+constexpr auto eval(const E& expr) {
+    return expr.eval();
+}
+
+// evaluates into existing storage, e.g. a view of foreign memory
+template <typename V, VectorOperand E>
+    requires VectorBaseContainer<std::remove_cvref_t<V>>
+constexpr void assign(V&& target, const E& expr) {
+    const auto e = as_expression(expr);
+    static_assert(decltype(e)::extent == std::remove_cvref_t<V>{}.size(), "Vector size mismatch");
+    for (std::size_t n{0}; n < decltype(e)::extent; n++)
+        target[n] = e[n];
+}
+
+// fused reductions, no intermediate vector is ever stored
+template <VectorExpr E>
+constexpr typename E::value_type sum(const E& expr) {
+    typename E::value_type s{0};
+    for (std::size_t n{0}; n < E::extent; n++)
+        s += expr[n];
+    return s;
+}
+
+template <VectorExpr E>
+constexpr typename E::value_type length(const E& expr) {
+    typename E::value_type s{0};
+    for (std::size_t n{0}; n < E::extent; n++) {
+        const auto e = expr[n];
+        s += e * e;
+    }
+    return std::sqrt(s);
+}
+}  // namespace vfunc
+
+template <vfunc::ArithmeticOperand L, vfunc::ArithmeticOperand R>
+constexpr auto operator+(const L& lhs, const R& rhs) noexcept {
+    return vfunc::make_binary<std::plus<>>(lhs, rhs);
+}
+
+template <vfunc::ArithmeticOperand L, vfunc::ArithmeticOperand R>
+constexpr auto operator-(const L& lhs, const R& rhs) noexcept {
+    return vfunc::make_binary<std::minus<>>(lhs, rhs);
+}
+
+// element-wise product, the lazy counterpart of vfunc::dot
+template <vfunc::ArithmeticOperand L, vfunc::ArithmeticOperand R>
+constexpr auto operator*(const L& lhs, const R& rhs) noexcept {
+    return vfunc::make_binary<std::multiplies<>>(lhs, rhs);
+}
+
+template <vfunc::ArithmeticOperand V, typename S>
+    requires std::is_arithmetic_v<S>
+constexpr auto operator*(const V& v, S factor) noexcept {
+    return vfunc::VectorScaled<vfunc::expression_t<V>, S>{vfunc::as_expression(v), factor};
+}
+
+template <vfunc::ArithmeticOperand V, typename S>
+    requires std::is_arithmetic_v<S>
+constexpr auto operator*(S factor, const V& v) noexcept {
+    return v * factor;
+}
+
+static_assert(!std::invocable<std::plus<>, VectorData<double, 3>, VectorData<double, 3>>, "bare storage is not taken over");
+static_assert(std::invocable<std::plus<>, AccessXYZ<VectorData<double, 3>>, AccessXYZ<VectorData<double, 3>>>);
+
+// ---- VectorArray.h ----
+// Structure-of-arrays storage for many vectors: all x components are contiguous, followed by
+// all y components and so on. The stride between the components of one vector is the capacity.
+#include <span>
+
+template <typename T>
+concept VectorArrayContainer =
+    requires {
+        typename T::value_type;
+        typename T::size_type;
+        { T::dimension } -> std::convertible_to<std::size_t>;
+    } && requires(T t, const T ct, typename T::size_type n) {
+        { ct.size() } -> std::same_as<typename T::size_type>;
+        { t.component(n) } -> std::same_as<std::span<typename T::value_type>>;
+        { ct.component(n) } -> std::same_as<std::span<const typename T::value_type>>;
+    };
+
+// proxy to one vector inside a VectorArray, T is const for read-only access
+template <typename T, std::size_t N>
+class VectorRef : public vfunc::VectorExpression<VectorRef<T, N>> {
+public:
+    using value_type = std::remove_const_t<T>;
+    using size_type = std::size_t;
+    using result_type = AccessXYZ<VectorData<value_type, N>>;
+    static constexpr std::size_t extent = N;
+
+    constexpr VectorRef(T* first, size_type stride) noexcept
+        : first_{first}, stride_{stride} {}
+
+    constexpr VectorRef(const VectorRef&) = default;
+
+    // assignment writes through to the array, it never rebinds the proxy
+    constexpr const VectorRef& operator=(const VectorRef& other) const requires(!std::is_const_v<T>) {
+        return *this = other.eval();
+    }
+
+    template <vfunc::VectorOperand V>
+        requires(!std::is_const_v<T>)
+    constexpr const VectorRef& operator=(const V& v) const {
+        const auto expr = vfunc::as_expression(v);
+        static_assert(decltype(expr)::extent == N, "Vector size mismatch");
+        for (size_type n{0}; n < N; n++)
+            (*this)[n] = expr[n];
+        return *this;
+    }
+
+    constexpr T& operator[](size_type n) const noexcept { return first_[n * stride_]; }
+
+    constexpr T& x() const noexcept requires(N >= 1) { return (*this)[0]; }
+    constexpr T& y() const noexcept requires(N >= 2) { return (*this)[1]; }
+    constexpr T& z() const noexcept requires(N >= 3) { return (*this)[2]; }
+
+private:
+    T* first_;
+    size_type stride_;
+};
+
+template<typename OS, typename T, std::size_t N>
+OS& operator<<(OS& os, const VectorRef<T, N>& v) {
+    return os << v.eval();
+}
+
+namespace vfunc::detail {
+#ifdef VFUNC_X86_DISPATCH
+__attribute__((target("avx2"))) inline void deinterleave3_avx2(const double* aos, double* x, double* y, double* z,
+                                                              std::size_t n) {
+    std::size_t i{0};
+    for (; i + 4 <= n; i += 4) {
+        __m256d vx, vy, vz;
+        load3_avx2(aos + 3 * i, vx, vy, vz);
+        _mm256_storeu_pd(x + i, vx);
+        _mm256_storeu_pd(y + i, vy);
+        _mm256_storeu_pd(z + i, vz);
+    }
+    for (; i < n; i++) {
+        x[i] = aos[3 * i];
+        y[i] = aos[3 * i + 1];
+        z[i] = aos[3 * i + 2];
+    }
+}
+
+__attribute__((target("avx2"))) inline void interleave3_avx2(const double* x, const double* y, const double* z,
+                                                            double* aos, std::size_t n) {
+    std::size_t i{0};
+    for (; i + 4 <= n; i += 4)
+        store3_avx2(aos + 3 * i, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), _mm256_loadu_pd(z + i));
+    for (; i < n; i++) {
+        aos[3 * i] = x[i];
+        aos[3 * i + 1] = y[i];
+        aos[3 * i + 2] = z[i];
+    }
+}
+#endif
+}  // namespace vfunc::detail
+
+template <typename T, std::size_t N>
+class VectorArray {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using reference = VectorRef<T, N>;
+    using const_reference = VectorRef<const T, N>;
+    static constexpr size_type dimension = N;
+
+    VectorArray() = default;
+
+    explicit VectorArray(size_type count)
+        : size_{count}, capacity_{count}, buffer_(N * count) {}
+
+    // converts an array of structs, e.g. std::vector<AccessXYZ<VectorData<T, N>>>
+    template <vfunc::VectorRange R>
+        requires(std::ranges::range_value_t<R>{}.size() == N &&
+                 std::same_as<typename std::ranges::range_value_t<R>::value_type, T>)
+    explicit VectorArray(const R& aos)
+        : VectorArray(std::ranges::size(aos)) {
+        if (size_ == 0)  // the data() of an empty range may be null
+            return;
+        const T* src = std::ranges::data(aos)->data();
+#ifdef VFUNC_X86_DISPATCH
+        if constexpr (std::same_as<T, double> && N == 3) {
+            if (vfunc::active_isa() != vfunc::ISA::scalar) {
+                vfunc::detail::deinterleave3_avx2(src, component(0).data(), component(1).data(),
+                                                  component(2).data(), size_);
+                return;
+            }
+        }
+#endif
+        for (size_type n{0}; n < N; n++) {
+            T* dst = component(n).data();
+            for (size_type i{0}; i < size_; i++)
+                dst[i] = src[i * N + n];
+        }
+    }
+
+    template <vfunc::VectorRange R>
+        requires(std::ranges::range_value_t<R>{}.size() == N &&
+                 std::same_as<typename std::ranges::range_value_t<R>::value_type, T>)
+    void to_aos(R&& aos) const {
+        vfunc::detail::check_sizes(size_, std::ranges::size(aos));
+        if (size_ == 0)
+            return;
+        T* dst = std::ranges::data(aos)->data();
+#ifdef VFUNC_X86_DISPATCH
+        if constexpr (std::same_as<T, double> && N == 3) {
+            if (vfunc::active_isa() != vfunc::ISA::scalar)
+                return vfunc::detail::interleave3_avx2(component(0).data(), component(1).data(),
+                                                       component(2).data(), dst, size_);
+        }
+#endif
+        for (size_type n{0}; n < N; n++) {
+            const T* src = component(n).data();
+            for (size_type i{0}; i < size_; i++)
+                dst[i * N + n] = src[i];
+        }
+    }
+
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return capacity_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    std::span<T> component(size_type n) noexcept { return {buffer_.data() + n * capacity_, size_}; }
+    std::span<const T> component(size_type n) const noexcept { return {buffer_.data() + n * capacity_, size_}; }
+
+    reference operator[](size_type i) noexcept { return {buffer_.data() + i, capacity_}; }
+    const_reference operator[](size_type i) const noexcept { return {buffer_.data() + i, capacity_}; }
+
+    void reserve(size_type capacity) {
+        if (capacity <= capacity_)
+            return;
+        std::vector<T> buffer(N * capacity);
+        for (size_type n{0}; n < N; n++)
+            std::copy_n(buffer_.data() + n * capacity_, size_, buffer.data() + n * capacity);
+        buffer_.swap(buffer);
+        capacity_ = capacity;
+    }
+
+    template <vfunc::VectorOperand V>
+    void push_back(const V& v) {
+        if (size_ == capacity_) {
+            // v may refer into this array, like arr.push_back(arr[0]), so read it before the columns move
+            const auto value = vfunc::as_expression(v).eval();
+            reserve(capacity_ == 0 ? 8 : 2 * capacity_);
+            (*this)[size_++] = value;
+            return;
+        }
+        (*this)[size_++] = v;
+    }
+
+private:
+    size_type size_{0};
+    size_type capacity_{0};
+    std::vector<T> buffer_;
+};
+
+// ---- ColumnDecorators.h ----
+template <VectorArrayContainer Base>
+    requires(Base::dimension >= 1)
+class ColumnX : public Base {
+public:
+    using T = typename Base::value_type;
+    template <typename... Args>
+    ColumnX(Args&&... args)
+        : Base(std::forward<Args>(args)...) {}
+
+    std::span<T> x() noexcept { return this->component(0); }
+    std::span<const T> x() const noexcept { return this->component(0); }
+};
+
+template <VectorArrayContainer Base>
+    requires(Base::dimension >= 2)
+class ColumnY : public Base {
+public:
+    using T = typename Base::value_type;
+    template <typename... Args>
+    ColumnY(Args&&... args)
+        : Base(std::forward<Args>(args)...) {}
+
+    std::span<T> y() noexcept { return this->component(1); }
+    std::span<const T> y() const noexcept { return this->component(1); }
+};
+
+template <VectorArrayContainer Base>
+    requires(Base::dimension >= 3)
+class ColumnZ : public Base {
+public:
+    using T = typename Base::value_type;
+    template <typename... Args>
+    ColumnZ(Args&&... args)
+        : Base(std::forward<Args>(args)...) {}
+
+    std::span<T> z() noexcept { return this->component(2); }
+    std::span<const T> z() const noexcept { return this->component(2); }
+};
+
+namespace vfunc {
+// euclidean norm of every vector in a structure-of-arrays, streams each component once
+template <VectorArrayContainer A, std::ranges::contiguous_range RO>
+    requires std::same_as<std::ranges::range_value_t<RO>, typename A::value_type>
+void length(const A& arr, RO&& out) {
+    using T = typename A::value_type;
+    const std::size_t n = arr.size();
+    detail::check_sizes(n, std::ranges::size(out));
+    T* dst = std::ranges::data(out);
+    std::array<const T*, A::dimension> columns;
+    for (std::size_t c{0}; c < A::dimension; c++)
+        columns[c] = arr.component(c).data();
+    for (std::size_t i{0}; i < n; i++) {
+        T s{0};
+        for (std::size_t c{0}; c < A::dimension; c++)
+            s += columns[c][i] * columns[c][i];
+        dst[i] = std::sqrt(s);
+    }
 }
+}  // namespace vfunc
+
+// ---- MatrixData.h ----
+// Small fixed-size matrices, stored row-major in a VectorData so they are VectorBaseContainers
+// themselves and work with everything above (decorators, expressions, views).
+#include <utility>
+
+template <typename T, std::size_t R, std::size_t C>
+struct MatrixData : VectorData<T, R * C> {
+    static constexpr std::size_t rows = R;
+    static constexpr std::size_t cols = C;
+};
+
+template <typename M>
+concept MatrixBaseContainer = VectorBaseContainer<M> && requires {
+    { M::rows } -> std::convertible_to<std::size_t>;
+    { M::cols } -> std::convertible_to<std::size_t>;
+} && (M::rows * M::cols == M{}.size());
+
+// ---- MatrixDecorators.h ----
+template <MatrixBaseContainer Base>
+class AccessRows : public Base {
+public:
+    using T = typename Base::value_type;
+    using owning_type = AccessRows<owning_vector_t<Base>>;
+    template <typename... Args>
+    constexpr AccessRows(Args&&... args)
+        : Base{std::forward<Args>(args)...} {}
+
+    constexpr AccessXYZ<VectorView<T, Base::cols>> row(std::size_t r) noexcept {
+        return {this->data() + r * Base::cols};
+    }
+    constexpr AccessXYZ<VectorView<const T, Base::cols>> row(std::size_t r) const noexcept {
+        return {this->data() + r * Base::cols};
+    }
+};
+
+template <MatrixBaseContainer Base>
+class AccessCols : public Base {
+public:
+    using T = typename Base::value_type;
+    using owning_type = AccessCols<owning_vector_t<Base>>;
+    template <typename... Args>
+    constexpr AccessCols(Args&&... args)
+        : Base{std::forward<Args>(args)...} {}
+
+    constexpr AccessXYZ<VectorView<T, Base::rows>> col(std::size_t c) noexcept {
+        return {this->data() + c, Base::cols};
+    }
+    constexpr AccessXYZ<VectorView<const T, Base::rows>> col(std::size_t c) const noexcept {
+        return {this->data() + c, Base::cols};
+    }
+};
+
+// ---- MatrixKernels.h ----
+namespace vfunc {
+namespace detail {
+// ((m[r][0] * v[0] + m[r][1] * v[1]) + ...), fully unrolled at compile time
+template <std::size_t Row, MatrixBaseContainer M, typename V, std::size_t... C>
+constexpr auto row_times(const M& m, const V& v, std::index_sequence<C...>) {
+    return (... + (m[Row * M::cols + C] * v[C]));
+}
+
+// entry I of the row-major product a * b
+template <std::size_t I, MatrixBaseContainer A, MatrixBaseContainer B, std::size_t... K>
+constexpr auto entry_times(const A& a, const B& b, std::index_sequence<K...>) {
+    return (... + (a[I / B::cols * A::cols + K] * b[K * B::cols + I % B::cols]));
+}
+
+template <MatrixBaseContainer M, VectorBaseContainer V>
+using matvec_result_t = std::conditional_t<M::rows == V{}.size(), owning_vector_t<V>,
+                                           AccessXYZ<VectorData<typename V::value_type, M::rows>>>;
+
+template <MatrixBaseContainer A, MatrixBaseContainer B>
+using matmul_result_t = std::conditional_t<A::cols == B::cols, owning_vector_t<A>,
+                                           MatrixData<typename A::value_type, A::rows, B::cols>>;
+}  // namespace detail
+
+template <MatrixBaseContainer M, VectorBaseContainer V>
+    requires(M::cols == V{}.size())
+constexpr detail::matvec_result_t<M, V> matvec(const M& m, const V& v) {
+    detail::matvec_result_t<M, V> result{};
+    [&]<std::size_t... R>(std::index_sequence<R...>) {
+        ((result[R] = detail::row_times<R>(m, v, std::make_index_sequence<M::cols>{})), ...);
+    }(std::make_index_sequence<M::rows>{});
+    return result;
+}
+
+template <MatrixBaseContainer A, MatrixBaseContainer B>
+    requires(A::cols == B::rows)
+constexpr detail::matmul_result_t<A, B> matmul(const A& a, const B& b) {
+    detail::matmul_result_t<A, B> result{};
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        ((result[I] = detail::entry_times<I>(a, b, std::make_index_sequence<A::cols>{})), ...);
+    }(std::make_index_sequence<A::rows * B::cols>{});
+    return result;
+}
+
+// Batched transformation of double 3-vectors by a 3x3 matrix, or by a 4x4 affine matrix whose
+// last row is ignored. Every path evaluates ((m0 * x + m1 * y) + m2 * z) + t in the same order.
+namespace detail {
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+inline void transform3_scalar(const double* m, std::size_t stride, bool affine, const double* v, double* out,
+                              std::size_t n) {
+    for (std::size_t i{0}; i < n; i++) {
+        // the point is read completely before it is written, so out may be v
+        const double x = v[3 * i], y = v[3 * i + 1], z = v[3 * i + 2];
+        for (std::size_t r{0}; r < 3; r++) {
+            const double* row = m + r * stride;
+            const double s = (row[0] * x + row[1] * y) + row[2] * z;
+            out[3 * i + r] = affine ? s + row[3] : s;
+        }
+    }
+}
+
+#ifdef VFUNC_X86_DISPATCH
+__attribute__((target("avx2"))) inline void transform3_avx2(const double* m, std::size_t stride, bool affine,
+                                                           const double* v, double* out, std::size_t n) {
+    __m256d c[3][4];
+    for (std::size_t r{0}; r < 3; r++)
+        for (std::size_t k{0}; k < (affine ? 4u : 3u); k++)
+            c[r][k] = _mm256_set1_pd(m[r * stride + k]);
+    blocked3<4, 3>(v, out, n, [&](const double* p, double* o) __attribute__((target("avx2"))) {
+        __m256d x, y, z, t[3];
+        load3_avx2(p, x, y, z);
+        for (std::size_t r{0}; r < 3; r++) {
+            t[r] = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(c[r][0], x), _mm256_mul_pd(c[r][1], y)),
+                                 _mm256_mul_pd(c[r][2], z));
+            if (affine)
+                t[r] = _mm256_add_pd(t[r], c[r][3]);
+        }
+        store3_avx2(o, t[0], t[1], t[2]);
+    });
+}
+
+__attribute__((target("avx512f"))) inline void transform3_avx512(const double* m, std::size_t stride, bool affine,
+                                                                const double* v, double* out, std::size_t n) {
+    __m512d c[3][4];
+    for (std::size_t r{0}; r < 3; r++)
+        for (std::size_t k{0}; k < (affine ? 4u : 3u); k++)
+            c[r][k] = _mm512_set1_pd(m[r * stride + k]);
+    blocked3<8, 3>(v, out, n, [&](const double* p, double* o) __attribute__((target("avx512f"))) {
+        __m512d x, y, z, t[3];
+        load3_avx512(p, x, y, z);
+        for (std::size_t r{0}; r < 3; r++) {
+            t[r] = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(c[r][0], x), _mm512_mul_pd(c[r][1], y)),
+                                 _mm512_mul_pd(c[r][2], z));
+            if (affine)
+                t[r] = _mm512_add_pd(t[r], c[r][3]);
+        }
+        store3_avx512(o, t[0], t[1], t[2]);
+    });
+}
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+inline void transform3(const double* m, std::size_t stride, bool affine, const double* v, double* out, std::size_t n,
+                       ISA isa) {
+    switch (clamp(isa)) {
+#ifdef VFUNC_X86_DISPATCH
+        case ISA::avx512:
+            return transform3_avx512(m, stride, affine, v, out, n);
+        case ISA::avx2:
+            return transform3_avx2(m, stride, affine, v, out, n);
+#endif
+        default:
+            return transform3_scalar(m, stride, affine, v, out, n);
+    }
+}
+}  // namespace detail
+
+// out[i] = m * in[i] for square m, or the affine map m * (in[i], 1) for m with one extra column
+template <MatrixBaseContainer M, VectorRange RI, VectorRange RO>
+    requires std::same_as<std::ranges::range_value_t<RI>, std::ranges::range_value_t<RO>> &&
+             (M::rows >= std::ranges::range_value_t<RI>{}.size()) &&
+             (M::cols == std::ranges::range_value_t<RI>{}.size() || M::cols == std::ranges::range_value_t<RI>{}.size() + 1)
+void transform(const M& m, const RI& in, RO&& out, ISA isa = active_isa()) {
+    using V = std::ranges::range_value_t<RI>;
+    constexpr std::size_t N{V{}.size()};
+    constexpr bool affine{M::cols == N + 1};
+    const std::size_t n = std::ranges::size(in);
+    detail::check_sizes(n, std::ranges::size(out));
+    if (n == 0)  // the data() of an empty range may be null
+        return;
+    const V* src = std::ranges::data(in);
+    V* dst = std::ranges::data(out);
+    if constexpr (detail::is_double3_v<V> && std::same_as<typename M::value_type, double>) {
+        detail::transform3(m.data(), M::cols, affine, src->data(), dst->data(), n, isa);
+    } else {
+        for (std::size_t i{0}; i < n; i++) {
+            V result{};
+            for (std::size_t r{0}; r < N; r++) {
+                auto s = m[r * M::cols] * src[i][0];
+                for (std::size_t c{1}; c < N; c++)
+                    s += m[r * M::cols + c] * src[i][c];
+                result[r] = affine ? s + m[r * M::cols + N] : s;
+            }
+            dst[i] = result;
+        }
+    }
 }
+}  // namespace vfunc
 
-class DoubleVec : public AccessZ<AccessY<AccessX<VectorData<double, 3>>>> {
+class DoubleVec : public AccessXYZ<VectorData<double, 3>> {
 public:
     using value_type = double;
     using SelfType = DoubleVec;
-    using BaseType = AccessZ<AccessY<AccessX<VectorData<double, 3>>>>;
+    using BaseType = AccessXYZ<VectorData<double, 3>>;
 
     template <typename... Args>
     constexpr DoubleVec(Args&&... args)
@@ -201,7 +1457,6 @@ public:
         return vfunc::dot(*this, v);
     }
 
-    template <VectorBaseContainer V>
     constexpr value_type length() const {
         return vfunc::length(*this);
     }
@@ -238,4 +1493,131 @@ int main() {
 
     DoubleVec mydoublevec{-1., -2., -3.};
     std::cout << mydoublevec << std::endl;
+
+    std::vector<DoubleVec> particles;
+    for (int n{0}; n < 11; n++)
+        particles.emplace_back(0.1 * n, -0.2 * n, 0.3 * n);
+    std::vector<double> norms(particles.size());
+    vfunc::length(particles, norms);
+    std::cout << "Batched norms (ISA " << static_cast<int>(vfunc::active_isa()) << "):";
+    for (auto norm : norms)
+        std::cout << ' ' << norm;
+    std::cout << std::endl;
+
+    bool reproducible{true};
+    for (std::size_t n{0}; n < particles.size(); n++)
+        reproducible &= norms[n] == vfunc::length(particles[n]);
+    std::cout << "Matches single vector length: " << std::boolalpha << reproducible << std::endl;
+
+    // evaluated in one loop at compile time, the result keeps its accessors
+    constexpr MyXYZVec shifted = (myxyzvec + 2. * myxyzvec - myxyzvec * myxyzvec).eval();
+    static_assert(shifted.z() == 2.5 + 5. - 6.25);
+    std::cout << shifted << std::endl;
+
+    auto lazy = myvec - myvec2 * 0.5;
+    std::cout << lazy.x() << ' ' << lazy.y() << ' ' << lazy.z() << std::endl;
+    std::cout << vfunc::length(myvec - myvec2) << ' ' << vfunc::sum(myvec * myvec2) << std::endl;
+    std::cout << mydoublevec.length() << std::endl;
+
+    using MyVecArray3 = ColumnZ<ColumnY<ColumnX<VectorArray<double, 3>>>>;
+    MyVecArray3 soa{particles};
+    soa.push_back(mydoublevec);
+    soa[0] = soa[soa.size() - 1] * 2.;
+    std::cout << "SoA x column:";
+    for (auto x : soa.x())
+        std::cout << ' ' << x;
+    std::cout << "\nSoA element 1: " << soa[1] << " with y = " << soa[1].y() << std::endl;
+    MyVecArray3 grown{particles};  // full, so appending one of its own vectors moves the columns
+    grown.push_back(grown[1]);
+    std::cout << "Appended element 1 again: " << grown[grown.size() - 1] << std::endl;
+
+    std::vector<double> soa_norms(soa.size());
+    vfunc::length(soa, soa_norms);
+    std::vector<DoubleVec> aos(soa.size());
+    soa.to_aos(aos);
+    std::cout << "Back to AoS: " << aos[0] << ", norm " << soa_norms[1] << " == " << norms[1] << std::endl;
+
+    using MyAlignedVec3 = AccessXYZ<AlignedVectorData<double, 3>>;
+    static_assert(sizeof(MyAlignedVec3) == 32 && alignof(MyAlignedVec3) == 32 && MyAlignedVec3{}.size() == 3);
+    constexpr MyAlignedVec3 aligned{1., 2., 3.};
+    static_assert(vfunc::dot(aligned, aligned).z() == 9.);
+    MyAlignedVec3 aligned2{0.5, -1.5, 2.5};
+    std::cout << vfunc::dot(aligned, aligned2) << ", sum " << vfunc::sum(aligned2) << ", length "
+              << vfunc::length(aligned2) << " == " << vfunc::length(MyVec3{0.5, -1.5, 2.5}) << std::endl;
+
+    // positions as they arrive in a raw frame: x y z, followed by a particle id
+    std::vector<double> frame;
+    for (int n{0}; n < 6; n++)
+        frame.insert(frame.end(), {0.1 * n, -0.2 * n, 0.3 * n, static_cast<double>(n)});
+    using MyVec3View = AccessZ<AccessY<AccessX<VectorView<double, 3>>>>;
+    VectorBufferView<MyVec3View> positions{frame.data(), 6, 4};
+    positions[1].x() = 42.;
+    vfunc::assign(positions[2], positions[2] * 10.);
+    std::cout << "View into frame: " << positions[1] << " / " << positions[2] << ", product "
+              << vfunc::dot(positions[3], positions[3]) << std::endl;
+
+    // every other coordinate of a packed buffer, i.e. a strided view of the components
+    using MyXYZView = AccessXYZ<VectorView<const double, 3>>;
+    const MyXYZView strided{frame.data(), std::size_t{2}};
+    std::cout << "Strided view: " << strided << " with z = " << strided.z() << std::endl;
+
+    std::vector<double> frame_norms(positions.size());
+    vfunc::length(positions, frame_norms);
+    std::cout << "Frame norms: " << frame_norms[3] << " == " << norms[3] << std::endl;
+
+    using Matrix3 = AccessCols<AccessRows<MatrixData<double, 3, 3>>>;
+    using Affine3 = AccessRows<MatrixData<double, 4, 4>>;
+    constexpr Matrix3 rot_z{0., -1., 0.,
+                            1., 0., 0.,
+                            0., 0., 1.};
+    constexpr auto rotated = vfunc::matvec(rot_z, myxyzvec);
+    static_assert(rotated.x() == -1.5 && rotated.y() == 0.5);
+    constexpr auto rot_twice = vfunc::matmul(rot_z, rot_z);
+    static_assert(rot_twice.row(0).x() == -1. && rot_twice.col(2).z() == 1.);
+    std::cout << "Rotated: " << rotated << ", second row of rotation: " << rot_z.row(1) << std::endl;
+
+    const Affine3 shift_rotate{0., -1., 0., 10.,
+                               1., 0., 0., 20.,
+                               0., 0., 1., 30.,
+                               0., 0., 0., 1.};
+    std::vector<DoubleVec> moved(particles.size());
+    vfunc::transform(shift_rotate, particles, moved);
+    std::cout << "Transformed: " << moved[2] << " from " << particles[2] << std::endl;
+
+    // in place, with each instruction set this machine supports
+    bool in_place_matches{true};
+    for (const auto isa : {vfunc::ISA::scalar, vfunc::ISA::avx2, vfunc::ISA::avx512}) {
+        std::vector<DoubleVec> in_place(particles);
+        vfunc::transform(shift_rotate, in_place, in_place, isa);
+        in_place_matches &= in_place == moved;
+    }
+    std::cout << "Transformed in place: " << in_place_matches << std::endl;
+
+#ifndef MYVEC_RECURSIVE_ACCESSXYZ
+    constexpr AccessXYZ<VectorData<int, 16>> wide{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    static_assert(wide.z() == 3 && wide.get<15>() == 16);
+    std::cout << "Component 10 of a 16-vector: " << wide.get<9>() << std::endl;
+#endif
 }
+
+#ifdef MYVEC_COMPILE_BENCH
+// Instantiates AccessXYZ for 4 value types and 1 to 16 dimensions, to compare build costs of the
+// flat and the recursive AccessXYZ.
+template <typename T, std::size_t... N>
+T touch_all(std::index_sequence<N...>) {
+    return (T{} + ... + AccessXYZ<VectorData<T, N + 1>>{}.x());
+}
+
+double compile_bench() {
+    constexpr auto dims = std::make_index_sequence<16>{};
+    return touch_all<float>(dims) + touch_all<double>(dims) + touch_all<int>(dims) + touch_all<long>(dims);
+}
+#endif
+
+// compile with g++ --std=c++20 -O2 -o myvec MyVec.cpp
+//
+// compile-time benchmark of the flat AccessXYZ against the recursive one, 64 instantiations each:
+//   time g++ --std=c++20 -g -c -DMYVEC_COMPILE_BENCH MyVec.cpp -o flat.o
+//   time g++ --std=c++20 -g -c -DMYVEC_COMPILE_BENCH -DMYVEC_RECURSIVE_ACCESSXYZ MyVec.cpp -o recursive.o
+//   nm -C flat.o | grep -c "AccessXYZ<.*>::AccessXYZ"       # instantiated constructors
+//   size flat.o recursive.o
@@ -1,34 +1,316 @@
 // using ADL (Argument-dependent name lookup)
 
+#include <algorithm>
 #include <array>
 #include <vector>
 #include <iostream>
 
+// ---- small_vector.h ----
+// A vector with room for N elements inside the object. Short sequences never touch the heap,
+// longer ones spill into an allocation like std::vector. Iterators are plain pointers; moving an
+// inline small_vector moves its elements, a spilled one hands over its allocation.
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <utility>
+
+namespace ns {
+template <typename T, std::size_t N>
+class small_vector {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    small_vector() noexcept = default;
+
+    // The filling constructors delegate to the default one, so the object is complete before the
+    // first element is made: if a copy throws, the destructor frees what was built and allocated.
+    explicit small_vector(size_type count, const T& value = T{})
+        : small_vector() {
+        reserve(count);
+        std::uninitialized_fill_n(data_, count, value);
+        size_ = count;
+    }
+
+    template <std::input_iterator It>
+    small_vector(It first, It last)
+        : small_vector() {
+        assign(first, last);
+    }
+
+    small_vector(std::initializer_list<T> init)
+        : small_vector(init.begin(), init.end()) {}
+
+    small_vector(const small_vector& other)
+        : small_vector(other.begin(), other.end()) {}
+
+    small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        steal(other);
+    }
+
+    ~small_vector() {
+        clear();
+        release();
+    }
+
+    // reuses the existing storage like std::vector
+    small_vector& operator=(const small_vector& other) {
+        if (this != &other)
+            assign(other.begin(), other.end());
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if (this != &other) {
+            clear();
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    small_vector& operator=(std::initializer_list<T> init) {
+        assign(init.begin(), init.end());
+        return *this;
+    }
+
+    template <std::input_iterator It>
+    void assign(It first, It last) {
+        clear();
+        if constexpr (std::forward_iterator<It>) {
+            const auto count = static_cast<size_type>(std::distance(first, last));
+            reserve(count);
+            std::uninitialized_copy(first, last, data_);
+            size_ = count;
+        } else {
+            for (; first != last; ++first)
+                emplace_back(*first);
+        }
+    }
+
+    iterator begin() noexcept { return data_; }
+    iterator end() noexcept { return data_ + size_; }
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+    const_iterator cbegin() const noexcept { return data_; }
+    const_iterator cend() const noexcept { return data_ + size_; }
+
+    T* data() noexcept { return data_; }
+    const T* data() const noexcept { return data_; }
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return capacity_; }
+    bool empty() const noexcept { return size_ == 0; }
+    bool is_inline() const noexcept { return data_ == inline_data(); }
+    static constexpr size_type inline_capacity() noexcept { return N; }
+
+    T& operator[](size_type i) noexcept { return data_[i]; }
+    const T& operator[](size_type i) const noexcept { return data_[i]; }
+    T& front() noexcept { return data_[0]; }
+    const T& front() const noexcept { return data_[0]; }
+    T& back() noexcept { return data_[size_ - 1]; }
+    const T& back() const noexcept { return data_[size_ - 1]; }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == capacity_) {
+            // the new element is built before the old ones move, args may refer to one of them
+            buffer storage = allocate(2 * capacity_ + 1);
+            T* element = ::new (static_cast<void*>(storage.get() + size_)) T(std::forward<Args>(args)...);
+            try {
+                relocate(std::move(storage));
+            } catch (...) {
+                std::destroy_at(element);
+                throw;
+            }
+        } else {
+            ::new (static_cast<void*>(data_ + size_)) T(std::forward<Args>(args)...);
+        }
+        return data_[size_++];
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    void pop_back() noexcept {
+        std::destroy_at(data_ + --size_);
+    }
+
+    void clear() noexcept {
+        std::destroy_n(data_, size_);
+        size_ = 0;
+    }
+
+    void reserve(size_type new_capacity) {
+        if (new_capacity > capacity_)
+            relocate(allocate(new_capacity));
+    }
+
+    void resize(size_type count, const T& value = T{}) {
+        reserve(count);
+        while (size_ > count)
+            pop_back();
+        while (size_ < count)
+            emplace_back(value);
+    }
+
+    friend void swap(small_vector& first, small_vector& second) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if (&first == &second)
+            return;
+        if (!first.is_inline() && !second.is_inline()) {
+            std::swap(first.data_, second.data_);
+        } else if (first.is_inline() && second.is_inline()) {
+            if constexpr (std::is_trivially_copyable_v<T>) {
+                std::byte tmp[sizeof(inline_)];
+                std::memcpy(tmp, first.inline_, sizeof(inline_));
+                std::memcpy(first.inline_, second.inline_, sizeof(inline_));
+                std::memcpy(second.inline_, tmp, sizeof(inline_));
+            } else {
+                auto& longer = first.size_ < second.size_ ? second : first;
+                auto& shorter = first.size_ < second.size_ ? first : second;
+                std::swap_ranges(shorter.data_, shorter.data_ + shorter.size_, longer.data_);
+                std::uninitialized_move(longer.data_ + shorter.size_, longer.end(), shorter.end());
+                std::destroy(longer.data_ + shorter.size_, longer.end());
+            }
+        } else {
+            // the inline elements move over, the allocation changes owner
+            auto& spilled = first.is_inline() ? second : first;
+            auto& local = first.is_inline() ? first : second;
+            T* storage = spilled.data_;
+            spilled.data_ = spilled.inline_data();
+            std::uninitialized_move_n(local.data_, local.size_, spilled.data_);
+            std::destroy_n(local.data_, local.size_);
+            local.data_ = storage;
+        }
+        std::swap(first.size_, second.size_);
+        std::swap(first.capacity_, second.capacity_);
+    }
+
+    friend bool operator==(const small_vector& a, const small_vector& b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+private:
+    T* inline_data() noexcept { return std::launder(reinterpret_cast<T*>(inline_)); }
+    const T* inline_data() const noexcept { return std::launder(reinterpret_cast<const T*>(inline_)); }
+
+    // a fresh buffer, given back to the allocator unless relocate() takes it over
+    struct deallocate {
+        size_type capacity;
+        void operator()(T* storage) const noexcept { std::allocator<T>{}.deallocate(storage, capacity); }
+    };
+    using buffer = std::unique_ptr<T, deallocate>;
+
+    static buffer allocate(size_type count) { return buffer{std::allocator<T>{}.allocate(count), deallocate{count}}; }
+
+    void release() noexcept {
+        if (!is_inline())
+            std::allocator<T>{}.deallocate(data_, capacity_);
+        data_ = inline_data();
+        capacity_ = N;
+    }
+
+    // moves the elements into `storage` and makes it the buffer; elements whose move may throw are
+    // copied instead, so a throw leaves the vector as it was and `storage` is freed
+    void relocate(buffer&& storage) {
+        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+            std::uninitialized_move_n(data_, size_, storage.get());
+        else
+            std::uninitialized_copy_n(data_, size_, storage.get());
+        std::destroy_n(data_, size_);
+        release();
+        capacity_ = storage.get_deleter().capacity;
+        data_ = storage.release();
+    }
+
+    // takes over the contents of `other`, which must be empty (or destroyed) afterwards
+    void steal(small_vector& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if (other.is_inline()) {
+            std::uninitialized_move_n(other.data_, other.size_, data_);
+            size_ = other.size_;
+            other.clear();
+            return;
+        }
+        data_ = std::exchange(other.data_, other.inline_data());
+        size_ = std::exchange(other.size_, 0);
+        capacity_ = std::exchange(other.capacity_, N);
+    }
+
+    alignas(T) std::byte inline_[N * sizeof(T)];
+    T* data_{inline_data()};
+    size_type size_{0};
+    size_type capacity_{N};
+};
+
+// what the sequence container path of addElement and print in Concepts/AssociativeContainer.cpp use
+static_assert(std::regular<small_vector<double, 4>>);
+static_assert(std::ranges::contiguous_range<small_vector<double, 4>>);
+static_assert(requires(small_vector<double, 4> v, double d) { v.push_back(d); });
+}
+
+// ---- Foo.h ----
+// Container is the type of vec, Foo keeps std::vector and SmallFoo stores up to 4 values inline.
+#include <span>
+
 namespace ns {
-class Foo {
+template <typename Container>
+class BasicFoo {
 public:
-    Foo() {}
+    BasicFoo() {}
 
-    Foo(const double* arr_d, const std::array<double, 4> arr_s, const std::vector<double>& v)
-        : arr_std(arr_s), vec(v) {
+    BasicFoo(const double* arr_d, const std::array<double, 4> arr_s, std::span<const double> v)
+        : arr_std(arr_s), vec(v.begin(), v.end()) {
         std::copy(arr_d, arr_d + 4, arr_dumb);
     }
 
-    Foo(const Foo& other) : Foo(other.arr_dumb, other.arr_std, other.vec) {}
-    
-    Foo(Foo&& other) noexcept : Foo() {
-        swap(*this, other);
+    BasicFoo(const BasicFoo& other)
+        : arr_std(other.arr_std), vec(other.vec) {
+        std::copy(other.arr_dumb, other.arr_dumb + 4, arr_dumb);
     }
 
-    virtual ~Foo(){}
+    BasicFoo(BasicFoo&& other) noexcept
+        : arr_std(other.arr_std), vec(std::move(other.vec)) {
+        std::copy(other.arr_dumb, other.arr_dumb + 4, arr_dumb);
+    }
+
+    virtual ~BasicFoo(){}
+
+    // Reuses the capacity of vec, so assigning between Foos of similar size does not allocate.
+    // The vector is assigned first and the arrays cannot throw, which keeps this strong as long
+    // as copying the elements cannot throw.
+    BasicFoo& operator=(const BasicFoo& other) {
+        if (this != &other) {
+            vec.assign(other.vec.begin(), other.vec.end());
+            arr_std = other.arr_std;
+            std::copy(other.arr_dumb, other.arr_dumb + 4, arr_dumb);
+        }
+        return *this;
+    }
 
-    Foo& operator=(Foo other) noexcept {
+    BasicFoo& operator=(BasicFoo&& other) noexcept {
         swap(*this, other);
         return *this;
     }
 
-    friend void swap(Foo& first, Foo& second) {
-        std::cout << "Hi there, I am doing swappydi-swappy things!\n";
+    // classic copy-and-swap, strong whatever the members are, at the price of a new allocation
+    BasicFoo& strong_assign(const BasicFoo& other) {
+        BasicFoo copy{other};
+        swap(*this, copy);
+        return *this;
+    }
+
+    friend void swap(BasicFoo& first, BasicFoo& second) noexcept {
         using std::swap;
         swap(first.arr_dumb, second.arr_dumb);
         swap(first.arr_std, second.arr_std);
@@ -51,13 +333,99 @@ public:
     }
 
 private:
-    double arr_dumb[4];
-    std::array<double, 4> arr_std;
-    std::vector<double> vec;
+    double arr_dumb[4]{};
+    std::array<double, 4> arr_std{};
+    Container vec;
 };
+
+using Foo = BasicFoo<std::vector<double>>;
+using SmallFoo = BasicFoo<small_vector<double, 4>>;
+}
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// copy-and-swap against capacity reuse, assigning equally sized Foos over and over
+void bench_assignment() {
+    const double arr[] = {1., 2., 3., 4.};
+    const std::array<double, 4> arr_std = {0.1, 0.2, 0.3, 0.4};
+    std::cout << "elements\tcopy-and-swap [ns]\treuse [ns]\n";
+    for (std::size_t n = 4; n <= 1'000'000; n = n < 10 ? 10 : n * 10) {
+        const ns::Foo source{arr, arr_std, std::vector<double>(n, 1.)};
+        ns::Foo target{arr, arr_std, std::vector<double>(n, 2.)};
+        const std::size_t reps = std::max<std::size_t>(100'000'000 / (n + 100), 20);
+        const auto time_ns = [&](auto&& assign) {
+            const auto start = std::chrono::steady_clock::now();
+            for (std::size_t r = 0; r < reps; ++r) {
+                assign();
+                asm volatile("" : : "g"(&target) : "memory");
+            }
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            return elapsed.count() / static_cast<double>(reps);
+        };
+        const double swapped = time_ns([&] { target.strong_assign(source); });
+        const double reused = time_ns([&] { target = source; });
+        std::cout << n << "\t\t" << swapped << "\t\t" << reused << '\n';
+    }
+}
+
+// construct, copy and swap with vec on the heap and inline, around the inline capacity of 4
+template <typename F>
+double ns_per_op(std::size_t reps, F&& op) {
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t r = 0; r < reps; ++r)
+        op();
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(reps);
+}
+
+template <typename F>
+void bench_container(const char* name, std::size_t n) {
+    const double arr[] = {1., 2., 3., 4.};
+    const std::array<double, 4> arr_std = {0.1, 0.2, 0.3, 0.4};
+    const std::vector<double> values(n, 1.);
+    constexpr std::size_t reps{2'000'000};
+    const double construct = ns_per_op(reps, [&] {
+        F foo{arr, arr_std, values};
+        asm volatile("" : : "g"(&foo) : "memory");
+    });
+    const F source{arr, arr_std, values};
+    const double copy = ns_per_op(reps, [&] {
+        F foo{source};
+        asm volatile("" : : "g"(&foo) : "memory");
+    });
+    F a{source}, b{source};
+    const double swapped = ns_per_op(reps, [&] {
+        using std::swap;
+        swap(a, b);
+        asm volatile("" : : "g"(&a), "g"(&b) : "memory");
+    });
+    std::cout << name << '\t' << n << "\t\t" << construct << "\t\t" << copy << "\t\t" << swapped << '\n';
+}
+
+void bench_small_vector() {
+    std::cout << "\t\telements\tconstruct [ns]\tcopy [ns]\tswap [ns]\n";
+    for (const std::size_t n : {2, 4, 8, 64}) {
+        bench_container<ns::Foo>("Foo     ", n);
+        bench_container<ns::SmallFoo>("SmallFoo", n);
+    }
 }
 
-int main() {
+// copies throw once `budget` runs out; the move may throw, so growing a small_vector copies
+struct Fragile {
+    static inline int budget{1'000};
+    std::string name;
+    explicit Fragile(std::string n) : name{std::move(n)} {}
+    Fragile(const Fragile& other) : name{other.name} {
+        if (--budget < 0)
+            throw std::runtime_error("copy failed");
+    }
+    Fragile(Fragile&& other) : name{std::move(other.name)} {}
+};
+
+int main(int argc, char* argv[]) {
     using std::swap;
     double arr[] = {1., 2., 3., 4.};
     std::array<double, 4> arr_std = {0.1, 0.2, 0.3, 0.4};
@@ -90,6 +458,43 @@ int main() {
     std::cout << "After:\n";
     foo.print();
     foo2.print();
+
+    std::cout << "\nMove Assignment\n";
+    foo3 = std::move(foo2);
+    foo3.print();
+
+    std::cout << "\nSmallFoo, vec without allocation\n";
+    ns::SmallFoo small{arr, arr_std, vec};
+    ns::SmallFoo small2{arr2, arr2_std, vec2};
+    swap(small, small2);
+    swap(small, small);  // a self-swap keeps the inline values
+    small.print();
+
+    ns::small_vector<Fragile, 2> fragile;
+    fragile.emplace_back("first");
+    fragile.emplace_back("second");
+    Fragile::budget = 1;
+    try {
+        fragile.emplace_back("third");
+    } catch (const std::runtime_error& e) {
+        std::cout << "Growing failed (" << e.what() << "), kept " << fragile.size() << " elements: "
+                  << fragile[0].name << ", " << fragile[1].name << '\n';
+    }
+    Fragile::budget = 1'000;
+    fragile.emplace_back("third");
+    Fragile::budget = 1;
+    try {
+        const auto copy = fragile;
+    } catch (const std::runtime_error& e) {
+        std::cout << "Copying the spilled vector failed (" << e.what() << "), nothing leaked\n";
+    }
+
+    // run with "bench" to compare copy-and-swap with capacity reusing assignment, and the
+    // heap allocated with the inline vec
+    if (argc > 1 && std::string_view{argv[1]} == "bench") {
+        bench_assignment();
+        bench_small_vector();
+    }
 }
 
-// compile with g++ -o copy_and_swap CopyAndSwap.cpp
+// compile with g++ -std=c++20 -O2 -o copy_and_swap CopyAndSwap.cpp
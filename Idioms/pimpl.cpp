@@ -9,8 +9,8 @@ public:
 
     Person(const Person& other);
     Person& operator=(const Person& other);
-    Person(Person&& other);
-    Person& operator=(Person&& other);
+    Person(Person&& other) noexcept;
+    Person& operator=(Person&& other) noexcept;
 
     int year_of_birth() const;
     std::string full_name() const;
@@ -24,6 +24,42 @@ private:
     std::unique_ptr<Impl> pimpl;
 };
 
+// ---- FastPerson.h ----
+// Same interface as Person, but the Impl lives in an aligned buffer inside the object, so
+// construction, copy and move do not allocate (names short enough for the small string buffer
+// do not either). Only the size and alignment of the buffer are part of the header, the Impl
+// itself stays hidden in the implementation, which checks that it fits.
+#include <cstddef>
+
+class FastPerson {
+public:
+    FastPerson();
+    ~FastPerson();
+
+    FastPerson(const FastPerson& other);
+    FastPerson& operator=(const FastPerson& other);
+    FastPerson(FastPerson&& other) noexcept;
+    FastPerson& operator=(FastPerson&& other) noexcept;
+
+    int year_of_birth() const;
+    std::string full_name() const;
+
+    void set_year_of_birth(int year);
+    void set_forename(std::string name);
+    void set_surname(std::string name);
+
+private:
+    struct Impl;
+    // two strings and an int, changing the Impl may require bumping these (and recompiling users)
+    static constexpr std::size_t impl_size{2 * sizeof(std::string) + 8};
+    static constexpr std::size_t impl_align{alignof(std::string)};
+
+    Impl* impl() noexcept;
+    const Impl* impl() const noexcept;
+
+    alignas(impl_align) std::byte storage[impl_size];
+};
+
 // could be in cpp file now
 
 struct Person::Impl {
@@ -41,18 +77,18 @@ Person::~Person() = default;
 Person::Person(Person const& other)
     : pimpl{std::make_unique<Impl>(*other.pimpl)} {}
 
+// a moved-from Person has no Impl, it can only be destroyed or assigned to
 Person& Person::operator=(Person const& other) {
-    *pimpl = *other.pimpl;
+    if (pimpl)
+        *pimpl = *other.pimpl;
+    else
+        pimpl = std::make_unique<Impl>(*other.pimpl);
     return *this;
 }
 
-Person::Person(Person&& other)
-    : pimpl{std::make_unique<Impl>(std::move(*other.pimpl))} {}
+Person::Person(Person&& other) noexcept = default;
 
-Person& Person::operator=(Person&& other) {
-    *pimpl = std::move(*other.pimpl);
-    return *this;
-}
+Person& Person::operator=(Person&& other) noexcept = default;
 
 int Person::year_of_birth() const {
     return pimpl->year_of_birth;
@@ -70,19 +106,463 @@ void Person::set_year_of_birth(int year){
 }
 
 void Person::set_forename(std::string name) {
-    pimpl->forename = name;
+    pimpl->forename = std::move(name);
 }
 
 void Person::set_surname(std::string name) {
-    pimpl->surname = name;
+    pimpl->surname = std::move(name);
+}
+
+// ---- FastPerson.cpp ----
+#include <new>
+
+struct FastPerson::Impl {
+    std::string forename{"none"};
+    std::string surname{"none"};
+    int year_of_birth{0};
+    // ... Potentially many more data members
+};
+
+FastPerson::Impl* FastPerson::impl() noexcept {
+    static_assert(sizeof(Impl) <= impl_size, "FastPerson::impl_size is too small for the Impl");
+    static_assert(impl_align % alignof(Impl) == 0, "FastPerson::impl_align does not suit the Impl");
+    return std::launder(reinterpret_cast<Impl*>(storage));
+}
+
+const FastPerson::Impl* FastPerson::impl() const noexcept {
+    return std::launder(reinterpret_cast<const Impl*>(storage));
+}
+
+FastPerson::FastPerson() {
+    new (storage) Impl{};
+}
+
+FastPerson::~FastPerson() {
+    impl()->~Impl();
+}
+
+FastPerson::FastPerson(FastPerson const& other) {
+    new (storage) Impl{*other.impl()};
+}
+
+FastPerson& FastPerson::operator=(FastPerson const& other) {
+    *impl() = *other.impl();
+    return *this;
+}
+
+FastPerson::FastPerson(FastPerson&& other) noexcept {
+    new (storage) Impl{std::move(*other.impl())};
+}
+
+FastPerson& FastPerson::operator=(FastPerson&& other) noexcept {
+    *impl() = std::move(*other.impl());
+    return *this;
+}
+
+int FastPerson::year_of_birth() const {
+    return impl()->year_of_birth;
+}
+
+std::string FastPerson::full_name() const {
+    std::string name{impl()->forename};
+    name += " ";
+    name += impl()->surname;
+    return name;
+}
+
+void FastPerson::set_year_of_birth(int year){
+    impl()->year_of_birth = year;
 }
 
-int main() {
+void FastPerson::set_forename(std::string name) {
+    impl()->forename = std::move(name);
+}
+
+void FastPerson::set_surname(std::string name) {
+    impl()->surname = std::move(name);
+}
+
+// ---- StringPool.h ----
+// Interns strings: every distinct string is stored once and identified by a dense 32 bit id.
+// The characters live in fixed blocks that never move, so views stay valid while the pool grows.
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class StringPool {
+public:
+    using Id = std::uint32_t;
+
+    Id intern(std::string_view s) {
+        if (const auto it = index_.find(s); it != index_.end())
+            return it->second;
+        const auto id = static_cast<Id>(views_.size());
+        views_.push_back(store(s));
+        index_.emplace(views_.back(), id);
+        return id;
+    }
+
+    std::string_view view(Id id) const { return views_[id]; }
+    std::size_t size() const { return views_.size(); }
+
+private:
+    static constexpr std::size_t block_size{1 << 16};
+
+    std::string_view store(std::string_view s) {
+        if (s.empty())  // needs no block, there may be none yet
+            return {};
+        if (s.size() > block_size) {
+            // an oversized string gets a block of its own, slotted in before the open block
+            auto block = std::make_unique<char[]>(s.size());
+            std::copy(s.begin(), s.end(), block.get());
+            const std::string_view stored{block.get(), s.size()};
+            blocks_.insert(blocks_.empty() ? blocks_.end() : blocks_.end() - 1, std::move(block));
+            return stored;
+        }
+        if (s.size() > block_size - used_) {
+            blocks_.push_back(std::make_unique<char[]>(block_size));
+            used_ = 0;
+        }
+        char* first = blocks_.back().get() + used_;
+        std::copy(s.begin(), s.end(), first);
+        used_ += s.size();
+        return {first, s.size()};
+    }
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::size_t used_{block_size};
+    std::vector<std::string_view> views_;
+    std::unordered_map<std::string_view, Id> index_;
+};
+
+// ---- PersonTable.h ----
+// Many people as columns: years of birth in one array, fore- and surnames as ids into a shared
+// StringPool. A row costs 12 bytes plus its share of the distinct names. Bulk loading interns
+// per thread and merges only the distinct names, sorting ranks the distinct names once and then
+// sorts integer keys, both run on `threads` threads.
+#include <span>
+#include <stdexcept>
+#include <thread>
+
+struct PersonRecord {
+    std::string_view forename;
+    std::string_view surname;
+    int year_of_birth;
+};
+
+class PersonTable {
+public:
+    using Row = std::size_t;
+
+    explicit PersonTable(unsigned threads = std::thread::hardware_concurrency())
+        : threads_{std::max(threads, 1u)} {}
+
+    Row add(std::string_view forename, std::string_view surname, int year_of_birth) {
+        forenames_.push_back(names_.intern(forename));
+        surnames_.push_back(names_.intern(surname));
+        years_.push_back(year_of_birth);
+        full_names_.clear();
+        return years_.size() - 1;
+    }
+
+    void load(std::span<const PersonRecord> records);
+    void sort_by_name();
+
+    std::size_t size() const { return years_.size(); }
+    int year_of_birth(Row row) const { return years_[row]; }
+    std::string_view forename(Row row) const { return names_.view(forenames_[row]); }
+    std::string_view surname(Row row) const { return names_.view(surnames_[row]); }
+
+    // writes "forename surname" into `buffer`, truncated if it does not fit, and returns the full length
+    std::size_t full_name(Row row, std::span<char> buffer) const {
+        if (row >= size())
+            throw std::out_of_range("PersonTable::full_name: no such row");
+        const std::string_view fore = forename(row), sur = surname(row);
+        const std::size_t length = fore.size() + 1 + sur.size();
+        char* out = buffer.data();
+        const auto put = [&](std::string_view part) {
+            const std::size_t n = std::min<std::size_t>(part.size(), buffer.data() + buffer.size() - out);
+            out = std::copy_n(part.data(), n, out);
+        };
+        put(fore);
+        put(" ");
+        put(sur);
+        return length;
+    }
+
+    // full names as views into a pool of their own, needs cache_full_names() after the last change
+    std::string_view full_name(Row row) const {
+        if (full_names_.size() != size())
+            throw std::logic_error("PersonTable::full_name: call cache_full_names() first");
+        if (row >= size())
+            throw std::out_of_range("PersonTable::full_name: no such row");
+        return full_name_pool_.view(full_names_[row]);
+    }
+    void cache_full_names();
+
+private:
+    // f(chunk, begin, end) on one contiguous chunk of [0, n) per thread
+    template <typename F>
+    void parallel_chunks(std::size_t n, F&& f) const {
+        std::vector<std::jthread> workers;
+        for (unsigned t = 1; t < threads_; ++t)
+            workers.emplace_back([&, t] { f(t, t * n / threads_, (t + 1) * n / threads_); });
+        f(0, 0, n / threads_);
+    }
+
+    unsigned threads_;
+    StringPool names_;
+    std::vector<StringPool::Id> forenames_;
+    std::vector<StringPool::Id> surnames_;
+    std::vector<int> years_;
+    StringPool full_name_pool_;
+    std::vector<StringPool::Id> full_names_;
+};
+
+// ---- PersonTable.cpp ----
+void PersonTable::load(std::span<const PersonRecord> records) {
+    const std::size_t first = size();
+    forenames_.resize(first + records.size());
+    surnames_.resize(first + records.size());
+    years_.resize(first + records.size());
+    full_names_.clear();
+
+    // every thread numbers the distinct names of its chunk, ...
+    struct Local {
+        std::unordered_map<std::string_view, StringPool::Id> index;
+        std::vector<std::string_view> distinct;
+        std::vector<StringPool::Id> global;
+        StringPool::Id number(std::string_view s) {
+            const auto [it, inserted] = index.try_emplace(s, static_cast<StringPool::Id>(distinct.size()));
+            if (inserted)
+                distinct.push_back(s);
+            return it->second;
+        }
+    };
+    std::vector<Local> locals(threads_);
+    parallel_chunks(records.size(), [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+        Local& local = locals[chunk];
+        for (std::size_t i = begin; i < end; ++i) {
+            forenames_[first + i] = local.number(records[i].forename);
+            surnames_[first + i] = local.number(records[i].surname);
+            years_[first + i] = records[i].year_of_birth;
+        }
+    });
+    // ... only those are interned one after the other ...
+    for (auto& local : locals) {
+        local.global.reserve(local.distinct.size());
+        for (const auto s : local.distinct)
+            local.global.push_back(names_.intern(s));
+    }
+    // ... and the rows are mapped to the global ids in parallel again
+    parallel_chunks(records.size(), [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+        const Local& local = locals[chunk];
+        for (std::size_t i = first + begin; i < first + end; ++i) {
+            forenames_[i] = local.global[forenames_[i]];
+            surnames_[i] = local.global[surnames_[i]];
+        }
+    });
+}
+
+void PersonTable::sort_by_name() {
+    // rank of every distinct name, so rows compare as (surname, forename) integer keys
+    std::vector<StringPool::Id> by_name(names_.size());
+    for (StringPool::Id id = 0; id < by_name.size(); ++id)
+        by_name[id] = id;
+    std::sort(by_name.begin(), by_name.end(),
+              [this](StringPool::Id a, StringPool::Id b) { return names_.view(a) < names_.view(b); });
+    std::vector<std::uint32_t> rank(names_.size());
+    for (std::uint32_t r = 0; r < by_name.size(); ++r)
+        rank[by_name[r]] = r;
+
+    struct Keyed {
+        std::uint64_t key;
+        std::uint32_t row;  // ties keep their order
+        bool operator<(const Keyed& other) const {
+            return key != other.key ? key < other.key : row < other.row;
+        }
+    };
+    const std::size_t n = size();
+    std::vector<Keyed> keyed(n);
+    parallel_chunks(n, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+            keyed[i] = {std::uint64_t{rank[surnames_[i]]} << 32 | rank[forenames_[i]], static_cast<std::uint32_t>(i)};
+        std::sort(keyed.begin() + begin, keyed.begin() + end);
+    });
+    // merge the sorted chunks pairwise, every round in parallel
+    for (std::size_t width = 1; width < threads_; width *= 2) {
+        std::vector<std::jthread> merges;
+        for (std::size_t t = 0; t + width < threads_; t += 2 * width) {
+            const auto at = [&](std::size_t chunk) { return keyed.begin() + std::min(chunk, std::size_t{threads_}) * n / threads_; };
+            merges.emplace_back([=] { std::inplace_merge(at(t), at(t + width), at(t + 2 * width)); });
+        }
+    }
+
+    const auto permute = [&](auto& column) {
+        auto sorted = column;
+        parallel_chunks(n, [&](std::size_t, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i)
+                sorted[i] = column[keyed[i].row];
+        });
+        column = std::move(sorted);
+    };
+    permute(forenames_);
+    permute(surnames_);
+    permute(years_);
+    full_names_.clear();
+}
+
+void PersonTable::cache_full_names() {
+    full_names_.resize(size());
+    std::string name;
+    for (Row row = 0; row < size(); ++row) {
+        name.resize(full_name(row, std::span<char>{}));
+        full_name(row, name);
+        full_names_[row] = full_name_pool_.intern(name);
+    }
+}
+
+// ---- benchmark ----
+#include <chrono>
+#include <string_view>
+#include <vector>
+
+template <typename F>
+double time_ms(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// construction, copy, move and a scan over a large array of records
+template <typename P>
+void bench_records(const char* name, std::size_t count) {
+    std::vector<P> people;
+    long long years{0};
+    const double create = time_ms([&] {
+        people.resize(count);
+        for (std::size_t i = 0; i < count; ++i)
+            people[i].set_year_of_birth(1900 + static_cast<int>(i % 120));
+    });
+    std::vector<P> copies;
+    const double copy = time_ms([&] { copies = people; });
+    std::vector<P> moved(count);
+    const double move = time_ms([&] { std::move(copies.begin(), copies.end(), moved.begin()); });
+    const double scan = time_ms([&] {
+        for (const auto& p : moved)
+            years += p.year_of_birth();
+    });
+    std::cout << name << " (" << sizeof(P) << " bytes): create " << create << " ms, copy " << copy
+              << " ms, move " << move << " ms, scan " << scan << " ms (" << years << ")\n";
+}
+
+// the same synthetic directory as FastPersons and as a PersonTable, with 1 and with all threads
+void bench_table(std::size_t count) {
+    std::vector<std::string> forenames, surnames;
+    for (int i = 0; i < 2'000; ++i)
+        forenames.push_back("Forename" + std::to_string(i));
+    for (int i = 0; i < 50'000; ++i)
+        surnames.push_back("Surname" + std::to_string(i * 7919 % 50'000));
+    std::vector<PersonRecord> records(count);
+    for (std::size_t i = 0; i < count; ++i)
+        records[i] = {forenames[i * 31 % forenames.size()], surnames[i * 17 % surnames.size()],
+                      1900 + static_cast<int>(i % 120)};
+
+    std::size_t chars{0};
+    std::vector<FastPerson> people(count);
+    const double fill = time_ms([&] {
+        for (std::size_t i = 0; i < count; ++i) {
+            people[i].set_forename(std::string{records[i].forename});
+            people[i].set_surname(std::string{records[i].surname});
+            people[i].set_year_of_birth(records[i].year_of_birth);
+        }
+    });
+    const double names = time_ms([&] {
+        for (const auto& p : people)
+            chars += p.full_name().size();
+    });
+    std::cout << "FastPerson:  fill " << fill << " ms, full_name " << names << " ms, "
+              << sizeof(FastPerson) << " bytes/row + heap names\n";
+
+    const unsigned max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned threads = 1; threads <= max_threads; threads = threads == max_threads ? threads + 1 : max_threads) {
+        PersonTable table{threads};
+        const double load = time_ms([&] { table.load(records); });
+        const double sort = time_ms([&] { table.sort_by_name(); });
+        char buffer[64];
+        const double buffered = time_ms([&] {
+            for (PersonTable::Row row = 0; row < table.size(); ++row)
+                chars += table.full_name(row, buffer);
+        });
+        const double cache = time_ms([&] { table.cache_full_names(); });
+        const double cached = time_ms([&] {
+            for (PersonTable::Row row = 0; row < table.size(); ++row)
+                chars += table.full_name(row).size();
+        });
+        std::cout << "PersonTable (" << threads << " thread(s)): load " << load << " ms, sort " << sort
+                  << " ms, full_name into buffer " << buffered << " ms, caching " << cache
+                  << " ms, cached full_name " << cached << " ms\n";
+    }
+    std::cout << "(" << chars << " characters)\n";
+}
+
+int main(int argc, char* argv[]) {
     Person p1{};
     p1.set_year_of_birth(2000);
     p1.set_forename("Alex");
     p1.set_surname("Balex");
     std::cout << "This is " << p1.full_name() << " who was born in " << p1.year_of_birth() << std::endl;
+
+    FastPerson p2{};
+    p2.set_year_of_birth(1990);
+    p2.set_forename("Chris");
+    p2.set_surname("Dalex");
+    FastPerson p3{std::move(p2)};
+    std::cout << "This is " << p3.full_name() << " who was born in " << p3.year_of_birth() << std::endl;
+
+    PersonTable table;
+    const PersonRecord records[]{{"Alex", "Balex", 2000}, {"Chris", "Dalex", 1990}, {"Alex", "Calex", 1980}};
+    table.load(records);
+    table.sort_by_name();
+    char buffer[32];
+    for (PersonTable::Row row = 0; row < table.size(); ++row) {
+        const std::size_t length = table.full_name(row, buffer);
+        std::cout << std::string_view{buffer, std::min(length, sizeof buffer)} << ", born "
+                  << table.year_of_birth(row) << '\n';
+    }
+
+    // an empty name before any block exists, a name longer than a pool block, then a short one
+    // that has to land in the open block
+    StringPool pool;
+    const auto empty_id = pool.intern("");
+    const std::string long_name(70'000, 'x');
+    const auto long_id = pool.intern(long_name);
+    const auto short_id = pool.intern("Alex");
+    std::cout << "Pooled a " << pool.view(long_id).size() << " character name and "
+              << pool.view(short_id) << (pool.view(long_id) == long_name ? ", intact" : ", CORRUPTED")
+              << (pool.view(empty_id).empty() ? "" : ", empty name CORRUPTED") << '\n';
+
+    table.cache_full_names();
+    try {
+        table.full_name(table.size());
+    } catch (const std::out_of_range& e) {
+        std::cout << e.what() << '\n';
+    }
+    try {
+        table.full_name(table.size(), buffer);
+    } catch (const std::out_of_range& e) {
+        std::cout << e.what() << " to write\n";
+    }
+
+    // run with "bench" to compare the heap and the in-object Impl, and the columnar table
+    if (argc > 1 && std::string_view{argv[1]} == "bench") {
+        bench_records<Person>("Person    ", 2'000'000);
+        bench_records<FastPerson>("FastPerson", 2'000'000);
+        bench_table(4'000'000);
+    }
 }
 
-// can be compiled with g++ -o pimpl pimpl.cpp
+// can be compiled with g++ -std=c++20 -O2 -pthread -o pimpl pimpl.cpp
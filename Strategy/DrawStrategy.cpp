@@ -84,6 +84,8 @@ private:
 // ---- GLDrawStrategy.h ----
 // #include <Sphere.h>
 // #include <Box.h>
+#include <array>
+#include <string_view>
 namespace gl {
 
 enum class Color {
@@ -92,19 +94,17 @@ enum class Color {
     blue
 };
 
-std::string to_string(const Color& color) {
-    switch(color) {
-        case Color::red:
-            return "red";
-        case Color::green:
-            return "green";
-        case Color::blue:
-            return "blue";
-        default:
-            return "unknown";
-        }
+// indexed by the enumerator, in declaration order
+inline constexpr std::array<std::string_view, 3> color_names{"red", "green", "blue"};
+
+constexpr std::string_view to_string(const Color& color) {
+    const auto index = static_cast<std::size_t>(color);
+    return index < color_names.size() ? color_names[index] : "unknown";
 }
 
+static_assert(to_string(Color::green) == "green");
+static_assert(to_string(static_cast<Color>(3)) == "unknown");
+
 class GLDrawStrategy {
 public:
     explicit GLDrawStrategy(Color color)